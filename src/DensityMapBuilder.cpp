@@ -0,0 +1,243 @@
+#include "DensityMapBuilder.h"
+#include "SimSnapshot.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+DensityMapBuilder::DensityMapBuilder(int threads, int w, int h) : pool(threads) {
+    for (int k = 0; k < kGammaLutSize; ++k) {
+        const double t = static_cast<double>(k) / (kGammaLutSize - 1);
+        gammaRamp[k] = static_cast<unsigned char>(std::round(std::pow(t, kGamma) * 255.0));
+    }
+    setResolution(w, h);
+}
+
+void DensityMapBuilder::setResolution(int w, int h) {
+    w = std::max(1, w);
+    h = std::max(1, h);
+    if (w == width && h == height) return;
+    width = w;
+    height = h;
+    tilesX = (width + kTileSize - 1) / kTileSize;
+    tilesY = (height + kTileSize - 1) / kTileSize;
+    const int bands = pool.getThreadCount() * kBandsPerThread;
+    const int rowsPerBand = (height + bands - 1) / bands;
+    bandRows = (rowsPerBand + kTileSize - 1) / kTileSize * kTileSize;
+
+    const size_t texelCount = static_cast<size_t>(width) * height;
+    rho.assign(texelCount, SimReal(0));
+    pixels.assign(texelCount * 3, 0);
+    texelX.resize(width);
+    texelY.resize(height);
+    for (int i = 0; i < width; ++i) {
+        texelX[i] = static_cast<SimReal>(-1.0f + (2.0f * (i + 0.5f) / static_cast<float>(width)));
+    }
+    for (int j = 0; j < height; ++j) {
+        texelY[j] = static_cast<SimReal>(-1.0f + (2.0f * (j + 0.5f) / static_cast<float>(height)));
+    }
+    const size_t tileCount = static_cast<size_t>(tilesX) * tilesY;
+    tileMin.resize(tileCount);
+    tileMax.resize(tileCount);
+    tileDirty.assign(tileCount, 0);
+    dirtyRects.clear();
+    dirtyRects.reserve(tileCount);
+    valid = false;
+}
+
+DensityMapBuilder::TexelRect DensityMapBuilder::tileRect(int tx, int ty, int tileCount) const {
+    const int x = tx * kTileSize;
+    const int y = ty * kTileSize;
+    return TexelRect{ x, y, std::min(width, x + tileCount * kTileSize) - x, std::min(height, y + kTileSize) - y };
+}
+
+DensityMapBuilder::TexelRect DensityMapBuilder::bandRect(size_t band) const {
+    const int y = static_cast<int>(band) * bandRows;
+    return TexelRect{ 0, y, width, std::min(height, y + bandRows) - y };
+}
+
+// Min/max of rho over tiles [tx0, tx1) of one row of tiles
+void DensityMapBuilder::reduceTiles(int tileRow, int tx0, int tx1) {
+    for (int tx = tx0; tx < tx1; ++tx) {
+        const TexelRect rect = tileRect(tx, tileRow, 1);
+        double lo = std::numeric_limits<double>::infinity();
+        double hi = 0.0;
+        for (int r = rect.y; r < rect.y + rect.h; ++r) {
+            const SimReal* row = &rho[static_cast<size_t>(r) * width];
+            for (int c = rect.x; c < rect.x + rect.w; ++c) {
+                lo = std::min(lo, static_cast<double>(row[c]));
+                hi = std::max(hi, static_cast<double>(row[c]));
+            }
+        }
+        tileMin[static_cast<size_t>(tileRow) * tilesX + tx] = lo;
+        tileMax[static_cast<size_t>(tileRow) * tilesX + tx] = hi;
+    }
+}
+
+// Flags every tile holding a texel the particle at (px, py) can reach
+void DensityMapBuilder::markSupport(SimReal px, SimReal py, SimReal h) {
+    size_t colLo, colHi, rowLo, rowHi;
+    SPHKernels::sampleSpan(texelX.data(), texelX.size(), px, h, colLo, colHi);
+    SPHKernels::sampleSpan(texelY.data(), texelY.size(), py, h, rowLo, rowHi);
+    if (colLo >= colHi || rowLo >= rowHi) return;
+    for (size_t ty = rowLo / kTileSize; ty <= (rowHi - 1) / kTileSize; ++ty) {
+        for (size_t tx = colLo / kTileSize; tx <= (colHi - 1) / kTileSize; ++tx) {
+            tileDirty[ty * tilesX + tx] = 1;
+        }
+    }
+}
+
+// Picks the color scale from the tile min/max; unless forced, adopts it (returning true)
+// only when it moved by more than the tolerance from the scale the pixels were colored with
+bool DensityMapBuilder::chooseScale(const SimSnapshot& snapshot, bool force) {
+    double rhoMin = std::numeric_limits<double>::infinity();
+    double rhoMax = 0.0;
+    for (size_t t = 0; t < tileMin.size(); ++t) {
+        rhoMin = std::min(rhoMin, tileMin[t]);
+        rhoMax = std::max(rhoMax, tileMax[t]);
+    }
+
+    // Choose green pivot within observed range; prefer rest density if it lies between min/max
+    double rhoGreen = snapshot.settings.restDensity;
+    if (rhoGreen < rhoMin || rhoGreen > rhoMax) {
+        rhoGreen = rhoMin + 0.35 * (rhoMax - rhoMin);
+    }
+    // Define hi scale so we see variation above green
+    double rhoHigh = rhoGreen + 0.65 * (rhoMax - rhoGreen);
+    if (rhoHigh <= rhoGreen) rhoHigh = rhoGreen + 1.0; // fallback
+
+    const double tolerance = kScaleTolerance * (rhoHigh - rhoMin);
+    if (!force && std::abs(rhoMin - colorMin) <= tolerance && std::abs(rhoGreen - colorGreen) <= tolerance &&
+        std::abs(rhoHigh - colorHigh) <= tolerance) {
+        return false;
+    }
+    colorMin = rhoMin;
+    colorGreen = rhoGreen;
+    colorHigh = rhoHigh;
+    return true;
+}
+
+void DensityMapBuilder::colorRect(const TexelRect& rect) {
+    // Ramp position t in [0, 1] of each half maps straight to a gamma table index
+    const double lutMax = kGammaLutSize - 1;
+    const double lowScale = lutMax / std::max(1e-12, colorGreen - colorMin);
+    const double highScale = lutMax / std::max(1e-12, colorHigh - colorGreen);
+    auto lutIndex = [lutMax](double v) {
+        return static_cast<size_t>(std::max(0.0, std::min(lutMax, v)) + 0.5);
+    };
+
+    for (int r = rect.y; r < rect.y + rect.h; ++r) {
+        const size_t rowStart = static_cast<size_t>(r) * width;
+        for (size_t k = rowStart + rect.x; k < rowStart + rect.x + rect.w; ++k) {
+            const double d = rho[k];
+            unsigned char* px = &pixels[k * 3];
+            if (d <= colorGreen) {
+                const unsigned char g = gammaRamp[lutIndex((d - colorMin) * lowScale)];
+                px[0] = 0;
+                px[1] = g;
+                px[2] = static_cast<unsigned char>(255 - g);
+            } else {
+                const unsigned char r = gammaRamp[lutIndex((d - colorGreen) * highScale)];
+                px[0] = r;
+                px[1] = static_cast<unsigned char>(255 - r);
+                px[2] = 0;
+            }
+        }
+    }
+}
+
+void DensityMapBuilder::build(const SimSnapshot& snapshot) {
+    const size_t w = static_cast<size_t>(width);
+    const size_t rows = static_cast<size_t>(height);
+    const size_t bands = bandCount();
+    const int tilesPerBand = bandRows / kTileSize;
+
+    // Pass 1: splat every particle into the texels within h of it, one band of rows per
+    // task (each band only takes the particles overlapping its rows), and reduce the
+    // band's tiles while its rows are still in cache
+    pool.run(bands, [&](size_t band) {
+        const size_t rowBegin = band * bandRows;
+        const size_t rowEnd = std::min(rows, rowBegin + bandRows);
+        snapshot.densityGrid(texelX.data(), w, texelY.data(), rows, rowBegin, rowEnd, rho.data());
+        const int firstTileRow = static_cast<int>(band) * tilesPerBand;
+        for (int ty = firstTileRow; ty < std::min(tilesY, firstTileRow + tilesPerBand); ++ty) {
+            reduceTiles(ty, 0, tilesX);
+        }
+    });
+    chooseScale(snapshot, true);
+
+    // Pass 2: color each band of rows
+    pool.run(bands, [&](size_t band) { colorRect(bandRect(band)); });
+
+    refX.resize(snapshot.size());
+    refY.resize(snapshot.size());
+    for (size_t i = 0; i < snapshot.size(); ++i) {
+        refX[snapshot.id[i]] = snapshot.x[i];
+        refY[snapshot.id[i]] = snapshot.y[i];
+    }
+    builtRadius = snapshot.kernels.h;
+    valid = true;
+    dirtyRects.clear();
+    dirtyRects.push_back(TexelRect{ 0, 0, width, height });
+    dirtyTileCount = getTileCount();
+}
+
+void DensityMapBuilder::update(const SimSnapshot& snapshot, double thresholdTexels) {
+    const size_t n = snapshot.size();
+    if (!valid || n != refX.size() || snapshot.kernels.h != builtRadius) {
+        build(snapshot);
+        return;
+    }
+
+    // A particle that moved past the threshold changes the texels around where the image
+    // last had it and around where it is now; one that did not keeps its old reference, so
+    // the error it leaves behind stays below the threshold however slowly it creeps
+    const SimReal h = snapshot.kernels.h;
+    const SimReal reach = static_cast<SimReal>(thresholdTexels * 2.0 / std::max(width, height));
+    const SimReal reach2 = reach * reach;
+    std::fill(tileDirty.begin(), tileDirty.end(), 0);
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t id = snapshot.id[i];
+        const SimReal dx = snapshot.x[i] - refX[id];
+        const SimReal dy = snapshot.y[i] - refY[id];
+        if (dx * dx + dy * dy <= reach2) continue;
+        markSupport(refX[id], refY[id], h);
+        markSupport(snapshot.x[i], snapshot.y[i], h);
+        refX[id] = snapshot.x[i];
+        refY[id] = snapshot.y[i];
+    }
+
+    // Runs of dirty tiles along each row of tiles become one rectangle each
+    dirtyRects.clear();
+    dirtyTileCount = 0;
+    for (int ty = 0; ty < tilesY; ++ty) {
+        const unsigned char* flags = &tileDirty[static_cast<size_t>(ty) * tilesX];
+        for (int tx = 0; tx < tilesX;) {
+            if (!flags[tx]) {
+                ++tx;
+                continue;
+            }
+            int end = tx;
+            while (end < tilesX && flags[end]) ++end;
+            dirtyRects.push_back(tileRect(tx, ty, end - tx));
+            dirtyTileCount += end - tx;
+            tx = end;
+        }
+    }
+    if (dirtyRects.empty()) return;
+
+    pool.run(dirtyRects.size(), [&](size_t k) {
+        const TexelRect& rect = dirtyRects[k];
+        snapshot.densityRect(texelX.data(), width, texelY.data(), height, rect.y, rect.y + rect.h, rect.x,
+                             rect.x + rect.w, rho.data());
+        reduceTiles(rect.y / kTileSize, rect.x / kTileSize, (rect.x + rect.w + kTileSize - 1) / kTileSize);
+    });
+
+    // The new tiles may have moved the color scale far enough to need every texel redone
+    if (chooseScale(snapshot, false)) {
+        pool.run(bandCount(), [&](size_t band) { colorRect(bandRect(band)); });
+        dirtyRects.clear();
+        dirtyRects.push_back(TexelRect{ 0, 0, width, height });
+    } else {
+        pool.run(dirtyRects.size(), [&](size_t k) { colorRect(dirtyRects[k]); });
+    }
+}
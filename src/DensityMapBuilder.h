@@ -0,0 +1,82 @@
+#pragma once
+#include "SimPrecision.h" // SimSnapshot forward declaration
+#include "ThreadPool.h"
+#include <array>
+#include <vector>
+
+// CPU side of the density map: samples a snapshot's density at every texel center over
+// [-1, 1]^2 and colors it into an RGB8 image (blue -> green at rest density -> red). Every
+// buffer is sized once per resolution, and the work runs as bands of rows on the builder's
+// own pool, so building a frame allocates nothing. No GL here; DensityMapRenderer uploads.
+//
+// update() refreshes only the square tiles that particles moved into or out of since the
+// image last accounted for them, and reports the changed texel rectangles for upload.
+class DensityMapBuilder {
+public:
+    struct TexelRect {
+        int x, y, w, h;  // Texels, origin at the bottom-left (first) row
+    };
+
+private:
+    static constexpr int kTileSize = 16;       // Texels per tile side; bands are whole rows of tiles
+    static constexpr int kBandsPerThread = 4;  // Slack for work stealing between uneven bands
+    static constexpr int kGammaLutSize = 1024;
+    static constexpr double kGamma = 0.8;  // Emphasizes the falloff toward each end of a ramp
+    // Color scale drift (fraction of its range) tolerated before every texel is recolored;
+    // about two 8-bit levels, so tiles colored under the older scale don't show seams
+    static constexpr double kScaleTolerance = 0.01;
+
+    int width = 0;
+    int height = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+    int bandRows = kTileSize;  // Every band rescans the particle list, so few, tall bands
+
+    // Own workers for density sampling; the simulation's pool belongs to the sim thread
+    ThreadPool pool;
+
+    std::vector<SimReal> texelX, texelY;     // Texel centers in simulation coordinates
+    std::vector<SimReal> rho;                // Density per texel, row-major
+    std::vector<unsigned char> pixels;       // RGB8, row-major, bottom row first
+    std::vector<double> tileMin, tileMax;    // Per-tile min/max of rho, row-major over tiles
+    std::array<unsigned char, kGammaLutSize> gammaRamp;  // round(255 t^gamma), t = k / (size - 1)
+
+    // Incremental state: the position each particle had when the image last covered it
+    // (by particle ID, so a reorder of the snapshot slots does not move them), the tiles
+    // to redo this update, and the color scale the pixels were last made with
+    bool valid = false;
+    SimReal builtRadius = 0;
+    std::vector<SimReal> refX, refY;
+    std::vector<unsigned char> tileDirty;
+    std::vector<TexelRect> dirtyRects;
+    int dirtyTileCount = 0;
+    double colorMin = 0, colorGreen = 0, colorHigh = 0;
+
+    size_t bandCount() const { return static_cast<size_t>((height + bandRows - 1) / bandRows); }
+    TexelRect bandRect(size_t band) const;
+    TexelRect tileRect(int tx, int ty, int tileCount) const;  // tileCount tiles starting at (tx, ty)
+    void reduceTiles(int tileRow, int tx0, int tx1);
+    void markSupport(SimReal px, SimReal py, SimReal h);
+    bool chooseScale(const SimSnapshot& snapshot, bool force);
+    void colorRect(const TexelRect& rect);
+
+public:
+    DensityMapBuilder(int threads, int w, int h);
+
+    void setResolution(int w, int h);
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    // Resamples and recolors the whole image from the snapshot
+    void build(const SimSnapshot& snapshot);
+    // Resamples only the tiles within h of a particle that moved more than threshold texels
+    // since the image last took it into account (before and after the move). Falls back to
+    // build() on the first call and whenever the particle count or smoothing radius changed.
+    void update(const SimSnapshot& snapshot, double thresholdTexels);
+
+    const unsigned char* getPixels() const { return pixels.data(); }
+    // Texel rectangles changed by the last build()/update(); empty when nothing changed
+    const std::vector<TexelRect>& getDirtyRects() const { return dirtyRects; }
+    int getDirtyTileCount() const { return dirtyTileCount; }
+    int getTileCount() const { return tilesX * tilesY; }
+};
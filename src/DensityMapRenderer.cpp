@@ -1,10 +1,6 @@
 #include "DensityMapRenderer.h"
-#include "FluidSimulation.h"
 #include <iostream>
-#include <vector>
-#include <cmath>
 #include <algorithm>
-#include <limits>
 
 static const char* quadVertexSrc = R"(
 #version 330 core
@@ -59,7 +55,9 @@ GLuint DensityMapRenderer::linkProgram(GLuint vs, GLuint fs) {
     return prog;
 }
 
-DensityMapRenderer::DensityMapRenderer() {}
+// Half the cores: the simulation thread keeps stepping on its own pool meanwhile
+DensityMapRenderer::DensityMapRenderer()
+    : builder(std::max(1, ThreadPool::hardwareThreads() / 2), 256, 256) {}
 
 DensityMapRenderer::~DensityMapRenderer() {
     cleanup();
@@ -104,7 +102,7 @@ bool DensityMapRenderer::init() {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, densityTexW, densityTexH, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, getWidth(), getHeight(), 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
     glBindTexture(GL_TEXTURE_2D, 0);
 
     return true;
@@ -130,78 +128,43 @@ void DensityMapRenderer::cleanup() {
 }
 
 void DensityMapRenderer::setResolution(int w, int h) {
-    if (w == densityTexW && h == densityTexH) return;
-    densityTexW = w;
-    densityTexH = h;
+    if (w == getWidth() && h == getHeight()) return;
+    builder.setResolution(w, h);
+    stale = true;
     glBindTexture(GL_TEXTURE_2D, bgTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, densityTexW, densityTexH, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, getWidth(), getHeight(), 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void DensityMapRenderer::draw(const FluidSimulation& sim) {
-    if (!enabled) return;
-
-    const size_t texelCount = static_cast<size_t>(densityTexW) * densityTexH;
-    std::vector<double> rho(texelCount);
-    double rhoMin = std::numeric_limits<double>::infinity();
-    double rhoMax = 0.0;
-
-    // Pass 1: sample density and compute min/max
-    for (int j = 0; j < densityTexH; ++j) {
-        float y = -1.0f + (2.0f * (j + 0.5f) / static_cast<float>(densityTexH));
-        for (int i = 0; i < densityTexW; ++i) {
-            float x = -1.0f + (2.0f * (i + 0.5f) / static_cast<float>(densityTexW));
-            double d = sim.densityAtFast(x, y, sim.getSmoothingRadius());
-            size_t idx = static_cast<size_t>(j) * densityTexW + static_cast<size_t>(i);
-            rho[idx] = d;
-            if (d < rhoMin) rhoMin = d;
-            if (d > rhoMax) rhoMax = d;
-        }
+void DensityMapRenderer::draw(const SimSnapshot& snapshot) {
+    if (!enabled) {
+        stale = true;
+        return;
     }
 
-    // Choose green pivot within observed range; prefer rest density if it lies between min/max
-    double rho0 = sim.getRestDensity();
-    double rhoGreen = rho0;
-    if (rhoGreen < rhoMin || rhoGreen > rhoMax) {
-        rhoGreen = rhoMin + 0.35 * (rhoMax - rhoMin);
-    }
-    // Define hi scale so we see variation above green
-    double rhoHigh = rhoGreen + 0.65 * (rhoMax - rhoGreen);
-    if (rhoHigh <= rhoGreen) rhoHigh = rhoGreen + 1.0; // fallback
-
-    // Optional gamma to emphasize falloff
-    auto saturate = [](double v){ return std::max(0.0, std::min(1.0, v)); };
-    const double gamma = 0.8;
-
-    std::vector<unsigned char> pixels(texelCount * 3);
-    for (int j = 0; j < densityTexH; ++j) {
-        for (int i = 0; i < densityTexW; ++i) {
-            size_t li = static_cast<size_t>(j) * densityTexW + static_cast<size_t>(i);
-            double d = rho[li];
-            float r = 0.0f, g = 0.0f, b = 0.0f;
-            if (d <= rhoGreen) {
-                double t = saturate((d - rhoMin) / std::max(1e-12, (rhoGreen - rhoMin)));
-                t = std::pow(t, gamma);
-                r = 0.0f;
-                g = static_cast<float>(t);
-                b = static_cast<float>(1.0 - t);
-            } else {
-                double t = saturate((d - rhoGreen) / std::max(1e-12, (rhoHigh - rhoGreen)));
-                t = std::pow(t, gamma);
-                r = static_cast<float>(t);
-                g = static_cast<float>(1.0 - t);
-                b = 0.0f;
-            }
-            size_t pi = li * 3;
-            pixels[pi + 0] = static_cast<unsigned char>(std::round(std::clamp(r, 0.0f, 1.0f) * 255.0f));
-            pixels[pi + 1] = static_cast<unsigned char>(std::round(std::clamp(g, 0.0f, 1.0f) * 255.0f));
-            pixels[pi + 2] = static_cast<unsigned char>(std::round(std::clamp(b, 0.0f, 1.0f) * 255.0f));
+    if (stale || ++framesSinceUpdate >= updateInterval) {
+        framesSinceUpdate = 0;
+        stale = false;
+        if (dirtyTiles) {
+            builder.update(snapshot, dirtyThreshold);
+        } else {
+            builder.build(snapshot);
         }
-    }
 
-    glBindTexture(GL_TEXTURE_2D, bgTexture);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, densityTexW, densityTexH, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
-    glBindTexture(GL_TEXTURE_2D, 0);
+        // Upload only the rectangles that changed, straight out of the full image: rows are
+        // tightly packed RGB (not always a multiple of 4 bytes), width texels apart
+        const unsigned char* pixels = builder.getPixels();
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, getWidth());
+        glBindTexture(GL_TEXTURE_2D, bgTexture);
+        for (const DensityMapBuilder::TexelRect& rect : builder.getDirtyRects()) {
+            const size_t offset = (static_cast<size_t>(rect.y) * getWidth() + rect.x) * 3;
+            glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.w, rect.h, GL_RGB, GL_UNSIGNED_BYTE,
+                            pixels + offset);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
 
     glUseProgram(quadProgram);
     glActiveTexture(GL_TEXTURE0);
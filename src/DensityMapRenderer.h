@@ -1,7 +1,7 @@
 #pragma once
 #include <glad/glad.h>
-
-class FluidSimulation; // forward declaration
+#include "SimPrecision.h" // SimSnapshot forward declaration
+#include "DensityMapBuilder.h"
 
 // Handles rendering of density map background
 class DensityMapRenderer {
@@ -12,9 +12,18 @@ private:
     GLuint quadProgram = 0;
     GLint loc_uTex = -1;
     
-    int densityTexW = 256;
-    int densityTexH = 256;
     bool enabled = false;
+
+    // Samples and colors the image on its own pool; this class only uploads and draws it
+    DensityMapBuilder builder;
+
+    // Refresh the image every updateInterval drawn frames, in full or (dirtyTiles) only
+    // where particles moved more than dirtyThreshold texels; stale forces the next one
+    int updateInterval = 1;
+    bool dirtyTiles = false;
+    double dirtyThreshold = 0.25;
+    int framesSinceUpdate = 0;
+    bool stale = true;
     
     static GLuint compileShader(GLenum type, const char* src);
     static GLuint linkProgram(GLuint vs, GLuint fs);
@@ -30,9 +39,18 @@ public:
     bool getEnabled() const { return enabled; }
     
     void setResolution(int w, int h);
-    int getWidth() const { return densityTexW; }
-    int getHeight() const { return densityTexH; }
+    int getWidth() const { return builder.getWidth(); }
+    int getHeight() const { return builder.getHeight(); }
+
+    void setUpdateInterval(int frames) { updateInterval = frames < 1 ? 1 : frames; }
+    void setDirtyTiles(bool enabled, double thresholdTexels) {
+        dirtyTiles = enabled;
+        dirtyThreshold = thresholdTexels;
+    }
+    // Tiles refreshed by the last update, out of getTileCount()
+    int getDirtyTileCount() const { return builder.getDirtyTileCount(); }
+    int getTileCount() const { return builder.getTileCount(); }
     
-    void draw(const FluidSimulation& sim);
+    void draw(const SimSnapshot& snapshot);
 };
 
@@ -3,8 +3,24 @@
 #include <cmath>
 #include <vector>
 #include <algorithm>
+#include <limits>
 #include "SPHKernels.h"
 
+namespace {
+// Particles per parallel chunk in the per-particle passes
+constexpr size_t kParticleGrain = 256;
+// Cell-group tasks per thread; enough slack for stealing to even out dense regions
+constexpr size_t kCellTasksPerThread = 8;
+// Jacobi relaxation of the implicit solver; lowered while the iteration diverges
+constexpr double kMinRelaxation = 0.05;
+constexpr double kMaxRelaxation = 0.5;
+// PBF: a constraint's multiplier is scaled by min(1, kPositionRelaxation / sqrt(n)) for n
+// particles in its kernel, since all n move at once in a Jacobi iteration and overshoot
+constexpr double kPositionRelaxation = 2.5;
+// PBF: artificial pressure strength k of s_corr (applied as extra compression)
+constexpr double kArtificialPressure = 0.01;
+}
+
 // -------------------- SPH Constants (tweak these) --------------------
 const double PARTICLE_RADIUS       = 0.02;
 const double SMOOTHING_RADIUS      = 0.11;        // h (default)
@@ -14,15 +30,75 @@ const double VISCOSITY_CONSTANT   = 0.01;         // mu (typical SPH friendly va
 const double SURFACE_TENSION_CONSTANT = 0.0000001;  // optional
 const double EPSILON              = 1e-6;        // small value to avoid div-by-zero
 
-// Precomputed kernel normalization constants (for convenience)
-const double M_PI = 3.14159265358979323846;
-// Note: these depend on h; compute on the fly instead of fixing at startup
+// Kernel normalization constants depend on h; they live in the KernelSet member,
+// rebuilt by setSmoothingRadius
 
 // --------------------------------------------------------------------
 
-FluidSimulation::FluidSimulation(int count)
+template <typename Real>
+template <typename Fn>
+void BasicFluidSimulation<Real>::forEachNeighbor(size_t i, Fn&& fn) const {
+    if (useNeighborLists) {
+        neighborList.forEach(i, fn);
+    } else {
+        spatialGrid.forEachCandidate(searchX()[i], searchY()[i], fn);
+    }
+}
+
+template <typename Real>
+template <typename Fn>
+void BasicFluidSimulation<Real>::forEachNeighborSpan(size_t i, Fn&& fn) const {
+    if (useNeighborLists) {
+        neighborList.forEachSpan(i, fn);
+    } else {
+        spatialGrid.forEachCandidateSpan(searchX()[i], searchY()[i], fn);
+    }
+}
+
+template <typename Real>
+template <typename Fn>
+void BasicFluidSimulation<Real>::forEachNeighborPair(Fn&& fn) const {
+    if (useNeighborLists) {
+        // Lists are symmetric, so keeping j > i visits each pair once
+        for (size_t i = 0; i < particles.size(); ++i) {
+            neighborList.forEach(i, [&](uint32_t j) {
+                if (j > i) fn(i, j);
+            });
+        }
+    } else {
+        spatialGrid.forEachCandidatePair(fn);
+    }
+}
+
+template <typename Real>
+template <typename Fn>
+void BasicFluidSimulation<Real>::forEachParticleByCell(Fn&& fn) {
+    if (threadPool.getThreadCount() == 1) {
+        for (size_t i = 0; i < particles.size(); ++i) fn(i);
+        return;
+    }
+    const std::vector<uint32_t>& cells = spatialGrid.getMortonCellOrder();
+    const uint32_t* sorted = spatialGrid.getSortedIndices();
+    threadPool.run(cellTaskWeight.size(), [&](size_t task) {
+        for (uint32_t c = cellTaskStart[task]; c < cellTaskStart[task + 1]; ++c) {
+            const uint32_t key = cells[c];
+            for (uint32_t k = spatialGrid.cellBegin(key); k < spatialGrid.cellEnd(key); ++k) {
+                fn(static_cast<size_t>(sorted[k]));
+            }
+        }
+    }, cellTaskWeight.data());
+}
+
+template <typename Real>
+BasicFluidSimulation<Real>::BasicFluidSimulation(int count)
     : gravity(0.0, -4.0),    // gravity Y approx -4 (from provided settings)
       timeStep(0.002f),
+      adaptiveTimeStep(false),
+      minTimeStep(0.0005f),
+      maxTimeStep(0.006f),
+      cflNumber(0.4f),
+      forceNumber(0.25f),
+      currentTimeStep(0.002f),
       top_border(1.0), bottom_border(-1.0),
       left_border(-1.0), right_border(1.0),
       damping(0.5f),
@@ -33,8 +109,28 @@ FluidSimulation::FluidSimulation(int count)
       nearPressureMultiplier(5.3),
       viscosityStrength(0.0),
       restDensity(3.6),
-      maxVelocity(2.01)
+      maxVelocity(2.01),
+      useNeighborLists(false),
+      neighborSkin(0.02),
+      neighborListSteps(0),
+      neighborListRebuilds(0),
+      searchPredicted(false),
+      gridDrift(-1),
+      kernelBackend(SimdKernels::bestSupportedBackend()),
+      useSymmetricForces(true),
+      solverMode(SolverMode::Explicit),
+      implicitRestDensity(0),
+      implicitMaxIterations(50),
+      implicitTolerance(0.005f),
+      positionIterations(4),
+      implicitIterations(0),
+      implicitDensityError(0),
+      implicitRelaxation(0.5f),
+      reorderInterval(32),
+      stepsSinceReorder(0),
+      deterministic(false)
 {
+    kernels.rebuild(smoothingRadius);
     particles.reserve(count);
     for (int i = 0; i < count; ++i) {
         float x = (float(rand()) / RAND_MAX) * 1.6f - 0.8f; // cluster toward center
@@ -43,14 +139,22 @@ FluidSimulation::FluidSimulation(int count)
         float vy = 0.0f;
 
         // mass of each particle: choose something reasonable (mass affects acceleration)
-        double mass = 1;
-        particles.push_back(Particle(x, y, vx, vy, mass));
+        Real mass = 1;
+        particles.add(x, y, vx, vy, mass);
     }
+    resetParticleIds();
 }
 
-FluidSimulation::FluidSimulation(int rows, int cols, float spacing, const Vec2& origin)
+template <typename Real>
+BasicFluidSimulation<Real>::BasicFluidSimulation(int rows, int cols, float spacing, const Vec& origin)
     : gravity(0.0, -4.0),
       timeStep(0.002f),
+      adaptiveTimeStep(false),
+      minTimeStep(0.0005f),
+      maxTimeStep(0.006f),
+      cflNumber(0.4f),
+      forceNumber(0.25f),
+      currentTimeStep(0.002f),
       top_border(1.0), bottom_border(-1.0),
       left_border(-1.0), right_border(1.0),
       damping(0.5f),
@@ -61,11 +165,31 @@ FluidSimulation::FluidSimulation(int rows, int cols, float spacing, const Vec2&
       nearPressureMultiplier(5.3),
       viscosityStrength(0.0),
       restDensity(2.7),
-      maxVelocity(2.01)
+      maxVelocity(2.01),
+      useNeighborLists(false),
+      neighborSkin(0.02),
+      neighborListSteps(0),
+      neighborListRebuilds(0),
+      searchPredicted(false),
+      gridDrift(-1),
+      kernelBackend(SimdKernels::bestSupportedBackend()),
+      useSymmetricForces(true),
+      solverMode(SolverMode::Explicit),
+      implicitRestDensity(0),
+      implicitMaxIterations(50),
+      implicitTolerance(0.005f),
+      positionIterations(4),
+      implicitIterations(0),
+      implicitDensityError(0),
+      implicitRelaxation(0.5f),
+      reorderInterval(32),
+      stepsSinceReorder(0),
+      deterministic(false)
 {
+    kernels.rebuild(smoothingRadius);
     int total = rows * cols;
     particles.reserve(total);
-    const double mass = 1;
+    const Real mass = 1;
 
     for (int r = 0; r < rows; ++r) {
         for (int c = 0; c < cols; ++c) {
@@ -77,217 +201,1053 @@ FluidSimulation::FluidSimulation(int rows, int cols, float spacing, const Vec2&
             if (y < bottom_border) y = (float)bottom_border;
             if (y > top_border) y = (float)top_border;
 
-            particles.emplace_back(x, y, 0.0, 0.0, mass);
+            particles.add(x, y, 0.0, 0.0, mass);
         }
     }
+    resetParticleIds();
 }
 
-float FluidSimulation::calculateSharedPressure(float densityA, float densityB) {
-    float pressureA = pressureOf(densityA);
-    float pressureB = pressureOf(densityB);
+template <typename Real>
+Real BasicFluidSimulation<Real>::calculateSharedPressure(Real densityA, Real densityB) {
+    Real pressureA = pressureOf(densityA);
+    Real pressureB = pressureOf(densityB);
     return (pressureA + pressureB) / 2;
 }
 
-Vec2 FluidSimulation::calculateGradient(const Particle& particle) {
-    Vec2 point = Vec2(particle.getX(), particle.getY());
-    Vec2 gradient(0.0, 0.0);
-    double thisDensity = particle.getDensity();
+template <typename Real>
+typename BasicFluidSimulation<Real>::Vec BasicFluidSimulation<Real>::calculateGradient(size_t index) {
+    Vec point = Vec(particles.nx[index], particles.ny[index]);
+    Vec gradient(0, 0);
+    Real thisDensity = particles.density[index];
+    Real thisNearDensity = particles.nearDensity[index];
 
-    for (int i = 0; i < particles.size(); i++) {
-        const Particle& otherParticle = particles[i];
-        if (&otherParticle == &particle) continue; // skip self
+    forEachNeighbor(index, [&](size_t i) {
+        if (i == index) return; // skip self
 
-        Vec2 other = Vec2(otherParticle.getX(), otherParticle.getY());
-        Vec2 r = point - other;
-        double dst = r.magnitude();
+        Vec other = Vec(particles.nx[i], particles.ny[i]);
+        Vec r = point - other;
+        Real dst = r.magnitude();
 
         if (dst < smoothingRadius && dst > 0.0) {
-            Vec2 direction = r.normalized();
-            double slope = SPHKernels::spikyPow2Derivative((float)smoothingRadius, (float)dst); // dW/dr
-            double mass = otherParticle.getMass();
-            double density = otherParticle.getDensity();
-            double sharedPressure = calculateSharedPressure(thisDensity, density); // e.g. pressure or temperature
-
-            // ∇A_i += m_j * (A_j / ρ_j) * ∇W(r_ij, h)
-            float scale = (float)(-slope * mass * sharedPressure / density);
+            Vec direction = r.normalized();
+            Real slope = kernels.spikyPow2DerivativeAt(dst);     // dW/dr
+            Real nearSlope = kernels.spikyPow3DerivativeAt(dst); // dWnear/dr
+            Real mass = particles.mass[i];
+            Real density = particles.density[i];
+            Real sharedPressure = calculateSharedPressure(thisDensity, density); // e.g. pressure or temperature
+            Real sharedNearPressure = calculateSharedNearPressure(thisNearDensity, particles.nearDensity[i]);
+
+            // ∇A_i += m_j * (A_j / ρ_j) * ∇W(r_ij, h), for pressure and near pressure
+            Real scale = -(slope * sharedPressure + nearSlope * sharedNearPressure) * mass / density;
             gradient += direction * scale;
         }
-    }
+    });
 
     return gradient;
 }
 
+// Batched form of calculateGradient + calculateViscosity: every neighbor span of a
+// particle goes through the SIMD force kernel, which needs the per-particle pressures
+// from computeDensities. Viscosity shares its distances and gathers, and costs
+// nothing while viscosityStrength is 0.
+template <typename Real>
+void BasicFluidSimulation<Real>::computePressureGradients(std::vector<Real>& gx, std::vector<Real>& gy) {
+    const size_t N = particles.size();
+    gx.assign(N, Real(0));
+    gy.assign(N, Real(0));
+
+    SimdKernels::ForceInput<Real> in;
+    in.x = particles.nx.data();
+    in.y = particles.ny.data();
+    in.mass = particles.mass.data();
+    in.density = particles.density.data();
+    in.pressure = particles.pressure.data();
+    in.nearDensity = particles.nearDensity.data();
+    in.nearPressureMultiplier = nearPressureMultiplier;
+    in.h = kernels.h;
+    in.slopeScale = kernels.spikyPow2DerivScale;
+    in.nearSlopeScale = kernels.spikyPow3DerivScale;
+    const bool viscous = viscosityStrength > 0;
+    in.vx = viscous ? particles.vx.data() : nullptr;
+    in.vy = viscous ? particles.vy.data() : nullptr;
+    in.viscosityScale = viscosityStrength * kernels.poly6Scale2D;
+
+    forEachParticleByCell([&](size_t i) {
+        forEachNeighborSpan(i, [&](const uint32_t* idx, size_t count) {
+            SimdKernels::accumulatePressureForce(kernelBackend, in, i, idx, count, gx[i], gy[i]);
+        });
+    });
+}
+
+// Pair form of calculateGradient + calculateViscosity: distance, kernel slopes and
+// shared pressures are evaluated once per pair. The pair force
+// m_i m_j ((P_ij dW/dr + Pnear_ij dWnear/dr) / (rho_i rho_j) + 2 mu (v_j - v_i) Poly6 / (rho_i + rho_j))
+// is applied to i and its negation to j, so momentum is conserved exactly.
+template <typename Real>
+void BasicFluidSimulation<Real>::accumulatePairPressureForces() {
+    const size_t N = particles.size();
+    const Real h2 = kernels.h2;
+    forceX.assign(N, Real(0));
+    forceY.assign(N, Real(0));
+
+    const Real* px = particles.nx.data();
+    const Real* py = particles.ny.data();
+    const Real* mass = particles.mass.data();
+    const Real* density = particles.density.data();
+    const Real* nearDensity = particles.nearDensity.data();
+    const Real* vx = particles.vx.data();
+    const Real* vy = particles.vy.data();
+    const bool viscous = viscosityStrength > 0;
+    const Real viscosityScale = viscosityStrength * kernels.poly6Scale2D;
+
+    forEachNeighborPair([&](size_t i, size_t j) {
+        const Real dx = px[i] - px[j];
+        const Real dy = py[i] - py[j];
+        const Real dst2 = dx * dx + dy * dy;
+        if (dst2 >= h2 || dst2 <= 0.0) return;
+
+        const Real dst = std::sqrt(dst2);
+        const Real slope = kernels.spikyPow2DerivativeAt(dst);     // dW/dr
+        const Real nearSlope = kernels.spikyPow3DerivativeAt(dst); // dWnear/dr
+        const Real sharedPressure = calculateSharedPressure(density[i], density[j]);
+        const Real sharedNearPressure = calculateSharedNearPressure(nearDensity[i], nearDensity[j]);
+        const Real massTerm = mass[i] * mass[j] / (density[i] * density[j]);
+        const Real scale = -(slope * sharedPressure + nearSlope * sharedNearPressure) * massTerm / dst;
+
+        Real fx = dx * scale;
+        Real fy = dy * scale;
+        if (viscous) {
+            const Real q = h2 - dst2;
+            const Real wv = q * q * q * viscosityScale * 2 * mass[i] * mass[j] / (density[i] + density[j]);
+            fx += (vx[j] - vx[i]) * wv;
+            fy += (vy[j] - vy[i]) * wv;
+        }
+        forceX[i] += fx;
+        forceY[i] += fy;
+        forceX[j] -= fx;
+        forceY[j] -= fy;
+    });
+}
+
 // -------------------- Density & Pressure --------------------
 
-// Compute density for a single particle (sum over neighbors)
-double FluidSimulation::densityOf(const Particle& particle) {
-    double density = 0.0;
+// Density and near density of a single particle in one neighbor traversal; the
+// distance and h - r are shared by the two kernels
+template <typename Real>
+void BasicFluidSimulation<Real>::densitiesOf(size_t i, Real& density, Real& nearDensity) {
+    // Distances are measured between predicted positions
+    const Real* px = particles.nx.data();
+    const Real* py = particles.ny.data();
+    const Real* mass = particles.mass.data();
+    density = 0;
+    nearDensity = 0;
 
-    for (const auto& neighbor : particles) {
-            double dist = particle.distanceTo(neighbor);
-            double influence = SPHKernels::spikyPow2(smoothingRadius, dist);
-            density += neighbor.getMass() * influence;
-    }
+    // The candidates include the particle itself, which contributes its own self-density
+    forEachNeighbor(i, [&](size_t j) {
+        Real dx = px[i] - px[j];
+        Real dy = py[i] - py[j];
+        Real r2 = dx * dx + dy * dy;
+        if (r2 >= kernels.h2) return;
+        Real t = kernels.h - std::sqrt(r2);
+        density += mass[j] * t * t * kernels.spikyPow2Scale;
+        nearDensity += mass[j] * t * t * t * kernels.spikyPow3Scale;
+    });
     // avoid zero density
-    return std::max(density, EPSILON);
+    density = std::max(density, Real(EPSILON));
+    nearDensity = std::max(nearDensity, Real(EPSILON));
 }
 
-double FluidSimulation::nearDensityOf(const Particle& particle) {
-    double nearDensity = 0.0;
-    for (const auto& neighbor : particles) {
-        double dist = particle.distanceTo(neighbor);
-        double influence = SPHKernels::spikyPow3(smoothingRadius, dist);
-        nearDensity += neighbor.getMass() * influence;
-    }
-    return std::max(nearDensity, EPSILON);
+// Density and near density of every particle in one batched pass. Each neighbor span
+// is handed to the SIMD kernel, which gathers predicted positions and masks lanes
+// outside h; the result matches densitiesOf up to summation order.
+template <typename Real>
+void BasicFluidSimulation<Real>::computeDensities() {
+    SimdKernels::DensityInput<Real> in;
+    in.x = particles.nx.data();
+    in.y = particles.ny.data();
+    in.mass = particles.mass.data();
+    in.h = kernels.h;
+    in.pow2Scale = kernels.spikyPow2Scale;
+    in.pow3Scale = kernels.spikyPow3Scale;
+
+    forEachParticleByCell([&](size_t i) {
+        Real density = 0;
+        Real nearDensity = 0;
+        forEachNeighborSpan(i, [&](const uint32_t* idx, size_t count) {
+            SimdKernels::accumulateDensity(kernelBackend, in, in.x[i], in.y[i], idx, count, density, nearDensity);
+        });
+        particles.density[i] = std::max(density, Real(EPSILON));
+        particles.nearDensity[i] = std::max(nearDensity, Real(EPSILON));
+        particles.pressure[i] = pressureOf(particles.density[i]);
+    });
 }
 
 // Pressure 
-double FluidSimulation::pressureOf(double density) {
-    double p = pressureMultiplier * (density - restDensity);
-    return std::max(p, 0.0);
+template <typename Real>
+Real BasicFluidSimulation<Real>::pressureOf(Real density) {
+    Real p = pressureMultiplier * (density - restDensity);
+    return std::max(p, Real(0));
 }
 
-double FluidSimulation::nearPressureOf(double nearDensity) {
-    double p = nearPressureMultiplier * nearDensity;
-    return std::max(p, 0.0);
+template <typename Real>
+Real BasicFluidSimulation<Real>::nearPressureOf(Real nearDensity) {
+    Real p = nearPressureMultiplier * nearDensity;
+    return std::max(p, Real(0));
 }
 
-float FluidSimulation::calculateSharedNearPressure(float nearDensityA, float nearDensityB) {
-    float pA = static_cast<float>(nearPressureOf(nearDensityA));
-    float pB = static_cast<float>(nearPressureOf(nearDensityB));
-    return (pA + pB) * 0.5f;
+template <typename Real>
+Real BasicFluidSimulation<Real>::calculateSharedNearPressure(Real nearDensityA, Real nearDensityB) {
+    Real pA = nearPressureOf(nearDensityA);
+    Real pB = nearPressureOf(nearDensityB);
+    return (pA + pB) * Real(0.5);
 }
 
-Vec2 FluidSimulation::calculateViscosity(const Particle& particle) {
-    // Placeholder viscosity force (returns zero) to keep interface valid.
-    // A full implementation would iterate neighbors and apply Laplacian kernel.
-    (void)particle;
-    return Vec2(0.0, 0.0);
+// Viscosity pulls a particle's velocity toward its neighbors'. After the force passes
+// divide by rho_i, the acceleration is mu * sum_j m_j (v_j - v_i) Poly6(r_ij) / rho_ij with
+// rho_ij the mean of the two densities, so mu is a kinematic viscosity (a relaxation rate
+// per second) whatever the mass scale. Scalar reference for the fused force passes.
+template <typename Real>
+typename BasicFluidSimulation<Real>::Vec BasicFluidSimulation<Real>::calculateViscosity(size_t i) {
+    Vec force(0, 0);
+    if (viscosityStrength <= 0) return force;
+    const Real* px = particles.nx.data();
+    const Real* py = particles.ny.data();
+    forEachNeighbor(i, [&](size_t j) {
+        if (j == i) return;
+        const Real dx = px[i] - px[j];
+        const Real dy = py[i] - py[j];
+        const Real r2 = dx * dx + dy * dy;
+        if (r2 <= 0) return;
+        const Real rhoI = particles.density[i];
+        const Real weight = viscosityStrength * kernels.poly6Density2D(r2) * particles.mass[j] * 2 * rhoI
+                            / (rhoI + particles.density[j]);
+        force += Vec(particles.vx[j] - particles.vx[i], particles.vy[j] - particles.vy[i]) * weight;
+    });
+    return force;
 }
 
 
 // -------------------- Update --------------------
 
-void FluidSimulation::update() {
+template <typename Real>
+void BasicFluidSimulation<Real>::update() {
     size_t N = particles.size();
-    Vec2 graivityForce = (gravity);
     if (N == 0) return;
 
-    // 1) Compute densities and pressures for all particles (stored in objects)
-    for (size_t i = 0; i < N; ++i) {
-        double density = densityOf(particles[i]);
-        particles[i].setDensity(density);
-        //particles[i].setPressure(pressureOf(density));
-    } 
+    // Positions at the start of the step, by particle ID, for render interpolation
+    previousX.resize(N);
+    previousY.resize(N);
+    threadPool.parallelFor(N, kParticleGrain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            previousX[particles.id[i]] = particles.x[i];
+            previousY[particles.id[i]] = particles.y[i];
+        }
+    });
 
-    for (size_t i = 0; i < N; ++i) {
-        Particle& pi = particles[i];
-        Vec2 pressureForce = calculateGradient(pi);
-        Vec2 pressureAcceleration = pressureForce / pi.getDensity();
-        pi.applyForce(pressureAcceleration.x + graivityForce.x, pressureAcceleration.y + graivityForce.y, timeStep);
+    if (solverMode == SolverMode::Explicit) {
+        stepExplicit();
+    } else if (solverMode == SolverMode::IISPH) {
+        refreshNeighbors(false);
+        buildCellTasks();
+        stepImplicit();
+    } else {
+        stepPositionBased();
     }
+    measureGridDrift();
+}
 
-    // 2) Move paricles
-    for (size_t i = 0; i < N; ++i) {
-        Particle& pi = particles[i];
+template <typename Real>
+void BasicFluidSimulation<Real>::stepExplicit() {
+    const size_t N = particles.size();
+    const Vec graivityForce = gravity;
+    implicitIterations = 0;
+
+    // 0) Predict where each particle ends the step (gravity included, over the last dt);
+    // the neighbor search, densities and pressure forces are all evaluated there, which
+    // lets pressure react to compression before it happens
+    const Real predictDt = currentTimeStep;
+    threadPool.parallelFor(N, kParticleGrain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const Real move = particles.active[i] ? predictDt : Real(0);
+            particles.nx[i] = particles.x[i] + (particles.vx[i] + graivityForce.x * predictDt) * move;
+            particles.ny[i] = particles.y[i] + (particles.vy[i] + graivityForce.y * predictDt) * move;
+        }
+    });
+
+    // 1) Refresh neighbor candidates around the predicted positions, then compute
+    // densities (and near densities) there; all SPH sums below only visit those candidates
+    refreshNeighbors(true);
+    buildCellTasks();
+    computeDensities();
+
+    // 2) Pressure forces. The pair pass scatters into j, so it only runs single-threaded,
+    // and never in deterministic mode, where 1 thread must match N threads bit for bit.
+    const bool symmetric = useSymmetricForces && !deterministic && threadPool.getThreadCount() == 1;
+    if (symmetric) {
+        accumulatePairPressureForces();
+    } else {
+        computePressureGradients(forceX, forceY);
+    }
+
+    // 3) Pick this step's dt, then apply forces and move particles; every particle is
+    // independent here
+    currentTimeStep = adaptiveTimeStep ? chooseTimeStep(symmetric) : timeStep;
+    Real* px = particles.x.data();
+    Real* py = particles.y.data();
+    Real* vx = particles.vx.data();
+    Real* vy = particles.vy.data();
+    const Real dt = currentTimeStep;
+    // Drag is tuned per fixed step; adaptive steps scale it so the decay per second stays the same
+    const Real drag = adaptiveTimeStep ? std::pow(velocityDrag, dt / timeStep) : velocityDrag;
+    threadPool.parallelFor(N, kParticleGrain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (symmetric) {
+                applyForce(i, forceX[i] + graivityForce.x, forceY[i] + graivityForce.y);
+            } else {
+                const Real invDensity = Real(1) / particles.density[i];
+                applyForce(i, forceX[i] * invDensity + graivityForce.x, forceY[i] * invDensity + graivityForce.y);
+            }
+        }
+        for (size_t i = begin; i < end; ++i) {
+            // Apply per-step velocity drag to help particles settle
+            vx[i] *= drag;
+            vy[i] *= drag;
+
+            // Integrate position
+            if (particles.active[i]) {
+                px[i] += vx[i] * dt;
+                py[i] += vy[i] * dt;
+            }
+            resolveCollisions(i);
+        }
+    });
+}
+
+// -------------------- Implicit (IISPH) solver --------------------
+
+template <typename Real>
+template <typename Fn>
+void BasicFluidSimulation<Real>::forEachNeighborWithin(const Real* px, const Real* py, size_t i, Fn&& fn) const {
+    const Real h2 = kernels.h2;
+    forEachNeighborSpan(i, [&](const uint32_t* idx, size_t count) {
+        for (size_t k = 0; k < count; ++k) {
+            const size_t j = idx[k];
+            const Real dx = px[i] - px[j];
+            const Real dy = py[i] - py[j];
+            const Real r2 = dx * dx + dy * dy;
+            if (j == i || r2 >= h2 || r2 < Real(EPSILON * EPSILON)) continue;
+            fn(j, dx, dy, std::sqrt(r2));
+        }
+    });
+}
+
+template <typename Real>
+Real BasicFluidSimulation<Real>::meanDensity() {
+    const Real* rho = particles.density.data();
+    const Real total = threadPool.reduce(particles.size(), 4096, Real(0), [&](size_t begin, size_t end) {
+        Real sum = 0;
+        for (size_t i = begin; i < end; ++i) sum += rho[i];
+        return sum;
+    }, [](Real a, Real c) { return a + c; });
+    return total / static_cast<Real>(particles.size());
+}
+
+// The box walls as fluid at rest density: returns the share of the density kernel lying
+// behind the walls (the density they add, per unit rest density) and its gradient in
+// gx, gy. Without them, particles along a wall are under-dense, feel no pressure and
+// pair up until the solver blows them apart.
+template <typename Real>
+Real BasicFluidSimulation<Real>::wallDensityAt(Real x, Real y, Real& gx, Real& gy) const {
+    const Real dist[4] = { x - left_border, right_border - x, y - bottom_border, top_border - y };
+    const Real normalX[4] = { 1, -1, 0, 0 };
+    const Real normalY[4] = { 0, 0, 1, -1 };
+    Real density = 0;
+    gx = 0;
+    gy = 0;
+    for (int w = 0; w < 4; ++w) {
+        Real fraction, slope;
+        SPHKernels::spikyPow2HalfPlane(dist[w] * kernels.invH, fraction, slope);
+        density += fraction;
+        gx += slope * normalX[w];
+        gy += slope * normalY[w];
+    }
+    gx *= kernels.invH;
+    gy *= kernels.invH;
+    return density;
+}
+
+// Implicit incompressible SPH (Ihmsen et al. 2013). Pressures are the solution of
+// sum_j A_ij p_j = rho0 - rho_adv, where rho_adv is the density the non-pressure forces
+// alone would produce. Each relaxed Jacobi iteration evaluates the pressure accelerations
+// a_i = -sum_j m_j (p_i / rho_i^2 + p_j / rho_j^2) grad W_ij and the density change they
+// cause, (A p)_i = dt^2 sum_j m_j (a_i - a_j) . grad W_ij, and iterations run (at least
+// two) until the average density error is below implicitTolerance. The pairs within h and
+// m_j grad W_ij are tabulated once per step; every pass is then a per-particle gather over that table, so results
+// do not depend on the thread count.
+// The density kernel is the Spiky (h - r)^2 kernel of computeDensities, and gradients
+// below are of that kernel: grad W_ij = W'(r) (x_i - x_j) / r.
+template <typename Real>
+void BasicFluidSimulation<Real>::stepImplicit() {
+    const size_t N = particles.size();
+    ImplicitBuffers& b = implicit;
+    b.advX.resize(N); b.advY.resize(N);
+    b.aii.resize(N); b.advDensity.resize(N);
+    b.pressure.resize(N); b.nextPressure.resize(N);
+    b.wallX.resize(N); b.wallY.resize(N);
+    b.pressureTerm.resize(N);
+    b.pairCount.resize(N);
+    const Real* mass = particles.mass.data();
+    const Real* rho = particles.density.data();
+    const SPHKernels::KernelSet<Real>& k = kernels;
+
+    // Densities at the current positions (the pass reads nx/ny). After an implicit step the
+    // solved pressures are carried (and reordered) in particles.pressure; half of them
+    // warm-start this solve.
+    const bool warmStart = implicitIterations > 0;
+    threadPool.parallelFor(N, kParticleGrain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            particles.nx[i] = particles.x[i];
+            particles.ny[i] = particles.y[i];
+            b.pressure[i] = warmStart ? Real(0.5) * particles.pressure[i] : Real(0);
+        }
+    });
+    computeDensities();
+    if (implicitRestDensity <= 0) implicitRestDensity = meanDensity();
+    const Real rho0 = implicitRestDensity;
+
+    // The box walls count as fluid at rest density (see wallDensityAt); G_i = rho0 times
+    // their gradient stands in for sum_b m_b grad W_ib in every term below
+    forEachParticleByCell([&](size_t i) {
+        Real gx, gy;
+        particles.density[i] += rho0 * wallDensityAt(particles.x[i], particles.y[i], gx, gy);
+        b.wallX[i] = rho0 * gx;
+        b.wallY[i] = rho0 * gy;
+    });
+
+    // Gravity is the only non-pressure force; the adaptive dt is then limited by CFL and gravity
+    forceX.assign(N, Real(0));
+    forceY.assign(N, Real(0));
+    currentTimeStep = adaptiveTimeStep ? chooseTimeStep(true) : timeStep;
+    const Real dt = currentTimeStep;
+    const Real dt2 = dt * dt;
+
+    // 1) Advected velocities
+    threadPool.parallelFor(N, kParticleGrain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const bool active = particles.active[i] != 0;
+            b.advX[i] = particles.vx[i] + (active ? dt * gravity.x : Real(0));
+            b.advY[i] = particles.vy[i] + (active ? dt * gravity.y : Real(0));
+        }
+    });
+
+    // 2) Neighbor table, filled in the same traversal that sums the advected density and
+    //    the diagonal a_ii = sum_j m_j (d_ii - d_ji) . grad W_ij, with
+    //    d_ii = -dt^2 / rho_i^2 sum_j m_j grad W_ij and d_ji = dt^2 m_i / rho_i^2 grad W_ij.
+    //    Every particle has pairStride slots, sized from the fullest neighborhood seen so
+    //    far; a neighborhood that outgrows them widens the stride and the table is refilled.
+    for (;;) {
+        const size_t stride = b.pairStride;
+        b.pairIndex.resize(N * stride);
+        b.pairGradX.resize(N * stride);
+        b.pairGradY.resize(N * stride);
+        forEachParticleByCell([&](size_t i) {
+            const size_t first = i * stride;
+            uint32_t count = 0;
+            Real sx = b.wallX[i], sy = b.wallY[i];
+            Real squares = 0, drift = 0;
+            forEachNeighborWithin(particles.x.data(), particles.y.data(), i, [&](size_t j, Real dx, Real dy, Real r) {
+                const Real w = mass[j] * k.spikyPow2DerivativeAt(r) / r;
+                const Real gx = w * dx, gy = w * dy;
+                sx += gx;
+                sy += gy;
+                squares += (gx * gx + gy * gy) / mass[j];
+                drift += (b.advX[i] - b.advX[j]) * gx + (b.advY[i] - b.advY[j]) * gy;
+                if (count < stride) {
+                    b.pairIndex[first + count] = static_cast<uint32_t>(j);
+                    b.pairGradX[first + count] = gx;
+                    b.pairGradY[first + count] = gy;
+                }
+                ++count;
+            });
+            b.pairCount[i] = count;
+            // Walls are static and carry no pressure, so they only add their i-terms
+            drift += b.advX[i] * b.wallX[i] + b.advY[i] * b.wallY[i];
+            const Real scale = dt2 / (rho[i] * rho[i]);
+            b.advDensity[i] = rho[i] + dt * drift;
+            b.aii[i] = -scale * (sx * sx + sy * sy) - scale * mass[i] * squares;
+        });
+        const uint32_t fullest = threadPool.reduce(N, 4096, uint32_t(0), [&](size_t begin, size_t end) {
+            uint32_t most = 0;
+            for (size_t i = begin; i < end; ++i) most = std::max(most, b.pairCount[i]);
+            return most;
+        }, [](uint32_t a, uint32_t c) { return std::max(a, c); });
+        if (fullest <= stride) break;
+        b.pairStride = fullest + fullest / 4;
+    }
+    const size_t stride = b.pairStride;
+    const uint32_t* pairCount = b.pairCount.data();
+    const uint32_t* pairJ = b.pairIndex.data();
+    const Real* pairGX = b.pairGradX.data();
+    const Real* pairGY = b.pairGradY.data();
+
+    // 3) Relaxed Jacobi iterations on the pressures, with pressureTerm = p / rho^2
+    threadPool.parallelFor(N, kParticleGrain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) b.pressureTerm[i] = b.pressure[i] / (rho[i] * rho[i]);
+    });
+    // a_i = -sum_j m_j (p_i / rho_i^2 + p_j / rho_j^2) grad W_ij, into forceX/forceY
+    auto pressureAccelerations = [&] {
+        threadPool.parallelFor(N, kParticleGrain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                Real ax = 0, ay = 0;
+                const Real pi = b.pressureTerm[i];
+                const size_t first = i * stride;
+                for (size_t e = first; e < first + pairCount[i]; ++e) {
+                    const Real w = pi + b.pressureTerm[pairJ[e]];
+                    ax -= w * pairGX[e];
+                    ay -= w * pairGY[e];
+                }
+                forceX[i] = ax - pi * b.wallX[i];
+                forceY[i] = ay - pi * b.wallY[i];
+            }
+        });
+    };
+    Real omega = implicitRelaxation;
+    Real bestError = std::numeric_limits<Real>::max();
+    int iteration = 0;
+    Real error = 0;
+    while (iteration < implicitMaxIterations) {
+        pressureAccelerations();
+        // p_i <- p_i + w / a_ii (rho0 - rho_adv_i - (A p)_i), clamped at zero, in fixed blocks
+        // that also sum the density error of the current pressures: |rho_i - rho0| where
+        // p_i > 0, and only compression where p_i = 0 (a particle may be under-dense there)
+        const Real measured = threadPool.reduce(N, kParticleGrain, Real(0), [&](size_t begin, size_t end) {
+            Real sum = 0;
+            for (size_t i = begin; i < end; ++i) {
+                const Real ax = forceX[i], ay = forceY[i];
+                Real change = ax * b.wallX[i] + ay * b.wallY[i];
+                const size_t first = i * stride;
+                for (size_t e = first; e < first + pairCount[i]; ++e) {
+                    const size_t j = pairJ[e];
+                    change += (ax - forceX[j]) * pairGX[e] + (ay - forceY[j]) * pairGY[e];
+                }
+                const Real p = b.pressure[i];
+                const Real residual = rho0 - b.advDensity[i] - dt2 * change;
+                Real next = 0;
+                if (std::abs(b.aii[i]) > Real(EPSILON)) next = std::max(p + omega / b.aii[i] * residual, Real(0));
+                b.nextPressure[i] = next;
+                b.pressureTerm[i] = next / (rho[i] * rho[i]);
+                sum += (p > 0 ? std::abs(residual) : std::max(-residual, Real(0))) / rho0;
+            }
+            return sum;
+        }, [](Real a, Real c) { return a + c; }) / static_cast<Real>(N);
+        ++iteration;
+        // Jacobi only converges while omega is below 2 / (largest eigenvalue of A / a_ii),
+        // which shrinks as neighborhoods grow. When the error grows, go back to the best
+        // pressures and lower omega by 30 %; each step then raises it by 5 %, so it stays
+        // just below the limit rather than climbing past it every few steps.
+        if (measured > bestError * Real(1.05)) {
+            b.pressure = b.bestPressure;
+            threadPool.parallelFor(N, kParticleGrain, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) b.pressureTerm[i] = b.pressure[i] / (rho[i] * rho[i]);
+            });
+            omega = std::max(Real(kMinRelaxation), omega * Real(0.7));
+            continue;
+        }
+        if (measured < bestError) {
+            bestError = measured;
+            b.bestPressure = b.pressure;
+        }
+        error = measured;
+        b.pressure.swap(b.nextPressure);
+        if (iteration >= 2 && error < implicitTolerance) break;
+    }
+    implicitRelaxation = std::min(Real(kMaxRelaxation), omega * Real(1.05));
+    implicitIterations = iteration;
+    implicitDensityError = error;
+
+    // 4) Accelerations of the final pressures, then the same drag, integration and
+    //    collisions as the explicit path
+    pressureAccelerations();
+    const Real drag = adaptiveTimeStep ? std::pow(velocityDrag, dt / timeStep) : velocityDrag;
+    Real* px = particles.x.data();
+    Real* py = particles.y.data();
+    Real* vx = particles.vx.data();
+    Real* vy = particles.vy.data();
+    threadPool.parallelFor(N, kParticleGrain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            particles.pressure[i] = b.pressure[i];
+            if (!particles.active[i]) continue;
+            vx[i] = (b.advX[i] + dt * forceX[i]) * drag;
+            vy[i] = (b.advY[i] + dt * forceY[i]) * drag;
+            px[i] += vx[i] * dt;
+            py[i] += vy[i] * dt;
+            particles.nx[i] = px[i] + vx[i] * dt;
+            particles.ny[i] = py[i] + vy[i] * dt;
+            resolveCollisions(i);
+        }
+    });
+}
+
+// -------------------- Position Based Fluids --------------------
+
+// Position Based Fluids (Macklin and Mueller 2013). Gravity moves particles to predicted
+// positions nx/ny; each iteration then evaluates the density constraint
+// C_i = rho_i / rho0 - 1 there and moves every particle by
+//   dp_i = 1/rho0 sum_j (lambda_i + lambda_j + s_corr) m_j grad W_ij,
+//   lambda_i = -C_i / (sum_k |grad_k C_i|^2 + eps),
+// all corrections of an iteration computed from the same positions (Jacobi). Velocities
+// are the displacement over dt. C is clamped at 0, so the constraint only pushes and a
+// free surface does not pull together; the artificial pressure s_corr keeps particles
+// from clustering in that clamped regime. Neighbors are searched at the predicted
+// positions, with grid cells (or lists) skin wider than h, and searched again whenever
+// the corrections carry a particle past that margin.
+template <typename Real>
+void BasicFluidSimulation<Real>::stepPositionBased() {
+    const size_t N = particles.size();
+    ImplicitBuffers& b = implicit;
+    b.lambda.resize(N);
+    b.lambdaScale.resize(N);
+    b.deltaX.resize(N);
+    b.deltaY.resize(N);
+    b.compression.resize(N);
+    const SPHKernels::KernelSet<Real>& k = kernels;
+
+    // Gravity is the only external force; the adaptive dt is limited by CFL and gravity
+    forceX.assign(N, Real(0));
+    forceY.assign(N, Real(0));
+    currentTimeStep = adaptiveTimeStep ? chooseTimeStep(true) : timeStep;
+    const Real dt = currentTimeStep;
+
+    // 1) Apply gravity and predict positions, kept inside the box
+    threadPool.parallelFor(N, kParticleGrain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (particles.active[i]) {
+                particles.vx[i] += dt * gravity.x;
+                particles.vy[i] += dt * gravity.y;
+            }
+            const bool active = particles.active[i] != 0;
+            const Real moveX = active ? particles.vx[i] * dt : Real(0);
+            const Real moveY = active ? particles.vy[i] * dt : Real(0);
+            particles.nx[i] = std::clamp(particles.x[i] + moveX, Real(left_border), Real(right_border));
+            particles.ny[i] = std::clamp(particles.y[i] + moveY, Real(bottom_border), Real(top_border));
+        }
+    });
+
+    // Search around the predicted positions, so pairs the prediction brings within h are
+    // seen. This may reorder the particles, so the array pointers are taken after it.
+    refreshNeighbors(true, neighborSkin);
+    buildCellTasks();
+    const Real* mass = particles.mass.data();
+    const Real* rho = particles.density.data();
+    Real* px = particles.x.data();
+    Real* py = particles.y.data();
+    Real* qx = particles.nx.data();
+    Real* qy = particles.ny.data();
+    Real* vx = particles.vx.data();
+    Real* vy = particles.vy.data();
 
-        // Apply per-step velocity drag to help particles settle
-        double vx = pi.getVx();
-        double vy = pi.getVy();
-        vx *= velocityDrag;
-        vy *= velocityDrag;
-        pi.setVelocity(vx, vy);
+    // Artificial pressure s_corr = -k (W(r) / W(dq))^n with the paper's k = 0.1, n = 4 and
+    // dq = 0.2 h. It is applied as that much extra compression, so it is scaled by the
+    // same 1 / sum |grad C|^2 as the constraint and needs no units of its own.
+    const Real correctionDistance = Real(0.2) * k.h;
+    const Real invCorrectionW = Real(1) / k.spikyPow2(correctionDistance * correctionDistance);
 
-        // Integrate position
-        pi.update(timeStep);
-        resolveCollisions(pi);
+    // 2) Constraint iterations
+    Real rho0 = implicitRestDensity;
+    Real error = 0;
+    for (int iteration = 0; iteration < positionIterations; ++iteration) {
+        computeDensities();  // Reads the predicted positions
+        if (iteration == 0 && rho0 <= 0) rho0 = implicitRestDensity = meanDensity();
+        const Real invRho0 = Real(1) / rho0;
+
+        // lambda_i, with grad_i C_i = 1/rho0 sum_j m_j grad W_ij (+ the walls' gradient)
+        // and grad_j C_i = -1/rho0 m_j grad W_ij
+        forEachParticleByCell([&](size_t i) {
+            Real wallX, wallY;
+            const Real density = rho[i] + rho0 * wallDensityAt(qx[i], qy[i], wallX, wallY);
+            Real gx = wallX, gy = wallY, sum2 = 0;
+            int count = 0;
+            forEachNeighborWithin(qx, qy, i, [&](size_t j, Real dx, Real dy, Real r) {
+                ++count;
+                const Real w = mass[j] * invRho0 * k.spikyPow2DerivativeAt(r) / r;
+                gx += w * dx;
+                gy += w * dy;
+                sum2 += w * w * (dx * dx + dy * dy);
+            });
+            const Real constraint = std::max(density * invRho0 - Real(1), Real(0));
+            b.lambdaScale[i] = Real(1) / (sum2 + gx * gx + gy * gy + Real(EPSILON));
+            const Real omega = std::min(Real(1), Real(kPositionRelaxation) / std::sqrt(Real(count + 1)));
+            b.lambda[i] = -constraint * b.lambdaScale[i] * omega;
+            b.compression[i] = constraint;
+        });
+
+        // dp_i, then move every particle at once
+        forEachParticleByCell([&](size_t i) {
+            Real wallX, wallY;
+            wallDensityAt(qx[i], qy[i], wallX, wallY);
+            Real dx_ = b.lambda[i] * wallX, dy_ = b.lambda[i] * wallY;
+            forEachNeighborWithin(qx, qy, i, [&](size_t j, Real dx, Real dy, Real r) {
+                const Real ratio = k.spikyPow2(r * r) * invCorrectionW;
+                const Real ratio2 = ratio * ratio;
+                const Real sCorr = Real(-kArtificialPressure) * ratio2 * ratio2 * Real(0.5) * (b.lambdaScale[i] + b.lambdaScale[j]);
+                const Real w = (b.lambda[i] + b.lambda[j] + sCorr) * mass[j] * invRho0 * k.spikyPow2DerivativeAt(r) / r;
+                dx_ += w * dx;
+                dy_ += w * dy;
+            });
+            b.deltaX[i] = dx_;
+            b.deltaY[i] = dy_;
+        });
+        threadPool.parallelFor(N, kParticleGrain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                if (!particles.active[i]) continue;
+                qx[i] = std::clamp(qx[i] + b.deltaX[i], Real(left_border), Real(right_border));
+                qy[i] = std::clamp(qy[i] + b.deltaY[i], Real(bottom_border), Real(top_border));
+            }
+        });
+        error = threadPool.reduce(N, 4096, Real(0), [&](size_t begin, size_t end) {
+            Real sum = 0;
+            for (size_t i = begin; i < end; ++i) sum += b.compression[i];
+            return sum;
+        }, [](Real a, Real c) { return a + c; }) / static_cast<Real>(N);
 
+        // Corrections that moved a particle past the skin can hide pairs now within h
+        if (iteration + 1 < positionIterations && neighborsStale(neighborSkin)) {
+            rebuildNeighbors(neighborSkin, false);
+            buildCellTasks();
+        }
     }
+    implicitIterations = positionIterations;
+    implicitDensityError = error;
+
+    // 3) Velocities from the displacement, then the same drag as the other solvers
+    const Real drag = adaptiveTimeStep ? std::pow(velocityDrag, dt / timeStep) : velocityDrag;
+    const Real invDt = Real(1) / dt;
+    threadPool.parallelFor(N, kParticleGrain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (!particles.active[i]) continue;
+            vx[i] = (qx[i] - px[i]) * invDt * drag;
+            vy[i] = (qy[i] - py[i]) * invDt * drag;
+            px[i] = qx[i];
+            py[i] = qy[i];
+            qx[i] = px[i] + vx[i] * dt;
+            qy[i] = py[i] + vy[i] * dt;
+        }
+    });
 }
 
-void FluidSimulation::resolveCollisions(Particle& pi) {
-    if (pi.getY() < bottom_border) {
-        pi.setPosition(pi.getX(), bottom_border);
-        pi.setVelocity(pi.getVx(), -pi.getVy() * damping);
+// CFL criterion keeps particles from crossing more than a fraction of h per step; the
+// force criterion bounds how far an acceleration can carry them from rest. Both maxima
+// come from a fixed-tree reduce, so the chosen dt is the same for any thread count.
+template <typename Real>
+Real BasicFluidSimulation<Real>::chooseTimeStep(bool symmetric) {
+    struct Extremes { Real speed2; Real accel2; };
+    const Vec g = gravity;
+    const Extremes extremes = threadPool.reduce(particles.size(), 4096, Extremes{ 0, 0 },
+        [&](size_t begin, size_t end) {
+            Extremes e{ 0, 0 };
+            for (size_t i = begin; i < end; ++i) {
+                if (!particles.active[i]) continue;
+                const Real scale = symmetric ? Real(1) : Real(1) / particles.density[i];
+                const Real invMass = Real(1) / particles.mass[i];
+                const Real ax = (forceX[i] * scale + g.x) * invMass;
+                const Real ay = (forceY[i] * scale + g.y) * invMass;
+                e.speed2 = std::max(e.speed2, particles.vx[i] * particles.vx[i] + particles.vy[i] * particles.vy[i]);
+                e.accel2 = std::max(e.accel2, ax * ax + ay * ay);
+            }
+            return e;
+        },
+        [](const Extremes& a, const Extremes& b) {
+            return Extremes{ std::max(a.speed2, b.speed2), std::max(a.accel2, b.accel2) };
+        });
+
+    Real dt = maxTimeStep;
+    const Real h = smoothingRadius;
+    if (extremes.speed2 > 0) dt = std::min(dt, cflNumber * h / std::sqrt(extremes.speed2));
+    if (extremes.accel2 > 0) dt = std::min(dt, forceNumber * std::sqrt(h / std::sqrt(extremes.accel2)));
+    // Viscosity relaxes velocities toward the neighbors' at about mu per second; the
+    // explicit update overshoots once mu * dt nears 1
+    if (viscosityStrength > 0) dt = std::min(dt, Real(0.5) / viscosityStrength);
+    return std::max(minTimeStep, dt);
+}
+
+// F = ma, so a = F/m; v += a * dt
+template <typename Real>
+void BasicFluidSimulation<Real>::applyForce(size_t i, Real fx, Real fy) {
+    if (!particles.active[i]) return;
+    const Real invMass = Real(1) / particles.mass[i];
+    particles.vx[i] += fx * invMass * currentTimeStep;
+    particles.vy[i] += fy * invMass * currentTimeStep;
+}
+
+template <typename Real>
+void BasicFluidSimulation<Real>::resolveCollisions(size_t i) {
+    Real& x = particles.x[i];
+    Real& y = particles.y[i];
+    Real& vx = particles.vx[i];
+    Real& vy = particles.vy[i];
+    if (y < bottom_border) {
+        y = bottom_border;
+        vy = -vy * damping;
     }
-    if (pi.getY() > top_border) {
-        pi.setPosition(pi.getX(), top_border);
-        pi.setVelocity(pi.getVx(), -pi.getVy() * damping);
+    if (y > top_border) {
+        y = top_border;
+        vy = -vy * damping;
     }
-    if (pi.getX() < left_border) {
-        pi.setPosition(left_border, pi.getY());
-        pi.setVelocity(-pi.getVx() * damping, pi.getVy());
+    if (x < left_border) {
+        x = left_border;
+        vx = -vx * damping;
     }
-    if (pi.getX() > right_border) {
-        pi.setPosition(right_border, pi.getY());
-        pi.setVelocity(-pi.getVx() * damping, pi.getVy());
+    if (x > right_border) {
+        x = right_border;
+        vx = -vx * damping;
     }
 }
-const std::vector<Particle>& FluidSimulation::getPositions() const {
-    return particles;
+
+template <typename Real>
+typename BasicFluidSimulation<Real>::View BasicFluidSimulation<Real>::getParticleView() const {
+    return View{ particles.x, particles.y, particles.vx, particles.vy };
+}
+
+template <typename Real>
+BasicSimSettings<Real> BasicFluidSimulation<Real>::getSettings() const {
+    BasicSimSettings<Real> settings;
+    settings.gravity = gravity;
+    settings.smoothingRadius = smoothingRadius;
+    settings.pressureMultiplier = pressureMultiplier;
+    settings.nearPressureMultiplier = nearPressureMultiplier;
+    settings.viscosityStrength = viscosityStrength;
+    settings.maxVelocity = maxVelocity;
+    settings.timeStep = timeStep;
+    settings.adaptiveTimeStep = adaptiveTimeStep;
+    settings.minTimeStep = minTimeStep;
+    settings.maxTimeStep = maxTimeStep;
+    settings.cflNumber = cflNumber;
+    settings.forceNumber = forceNumber;
+    settings.damping = damping;
+    settings.velocityDrag = velocityDrag;
+    settings.collisionDamping = collisionDamping;
+    settings.restDensity = restDensity;
+    settings.neighborSkin = neighborSkin;
+    settings.reorderInterval = reorderInterval;
+    settings.useNeighborLists = useNeighborLists;
+    settings.useSymmetricForces = useSymmetricForces;
+    settings.deterministic = deterministic;
+    settings.kernelBackend = kernelBackend;
+    settings.solverMode = solverMode;
+    settings.implicitRestDensity = implicitRestDensity;
+    settings.implicitMaxIterations = implicitMaxIterations;
+    settings.implicitTolerance = implicitTolerance;
+    settings.positionIterations = positionIterations;
+    settings.threadCount = threadPool.getThreadCount();
+    return settings;
 }
 
-double FluidSimulation::densityAt(float x, float y) const {
-    double density = 0.0;
-    for (const auto& neighbor : particles) {
-        double dx = static_cast<double>(x) - neighbor.getX();
-        double dy = static_cast<double>(y) - neighbor.getY();
-        double dist = std::sqrt(dx * dx + dy * dy);
-        double influence = SPHKernels::spikyPow2(smoothingRadius, dist);
-        density += neighbor.getMass() * influence;
+template <typename Real>
+void BasicFluidSimulation<Real>::writeSnapshot(BasicSimSnapshot<Real>& snapshot) const {
+    snapshot.x.assign(particles.x.begin(), particles.x.end());
+    snapshot.y.assign(particles.y.begin(), particles.y.end());
+    snapshot.vx.assign(particles.vx.begin(), particles.vx.end());
+    snapshot.vy.assign(particles.vy.begin(), particles.vy.end());
+    snapshot.mass.assign(particles.mass.begin(), particles.mass.end());
+    snapshot.id.assign(particles.id.begin(), particles.id.end());
+    const size_t N = particles.size();
+    snapshot.prevX.resize(N);
+    snapshot.prevY.resize(N);
+    const bool stepped = previousX.size() == N;
+    for (size_t i = 0; i < N; ++i) {
+        snapshot.prevX[i] = stepped ? previousX[particles.id[i]] : particles.x[i];
+        snapshot.prevY[i] = stepped ? previousY[particles.id[i]] : particles.y[i];
     }
-    return std::max(density, EPSILON);
-}
-
-double FluidSimulation::densityAtFast(float x, float y, double smoothingRadius) const {
-    // Compute using squared distance to avoid sqrt and inline Poly6
-    const double h = smoothingRadius;
-    const double h2 = h * h;
-    const double volume = M_PI * pow(h, 8) / 4.0; // matches smoothingKernel
-    double density = 0.0;
-    for (const auto& neighbor : particles) {
-        const double dx = static_cast<double>(x) - neighbor.getX();
-        const double dy = static_cast<double>(y) - neighbor.getY();
-        const double r2 = dx * dx + dy * dy;
-        const double t = h2 - r2;
-        if (t > 0.0) {
-            const double w = (t * t * t) / volume; // Poly6
-            density += neighbor.getMass() * w;
+    snapshot.settings = getSettings();
+    snapshot.kernels = kernels;
+    snapshot.lastTimeStep = currentTimeStep;
+    snapshot.implicitIterations = implicitIterations;
+    snapshot.implicitDensityError = implicitDensityError;
+    snapshot.neighborListRebuilds = neighborListRebuilds;
+    snapshot.neighborListSteps = neighborListSteps;
+}
+
+template <typename Real>
+Particle BasicFluidSimulation<Real>::getParticle(size_t slot) const {
+    Particle p(particles.x[slot], particles.y[slot], particles.vx[slot], particles.vy[slot], particles.mass[slot]);
+    p.setDensity(particles.density[slot]);
+    p.setNearDensity(particles.nearDensity[slot]);
+    p.setPressure(particles.pressure[slot]);
+    p.setActive(particles.active[slot] != 0);
+    return p;
+}
+
+template <typename Real>
+uint64_t BasicFluidSimulation<Real>::getStateHash() const {
+    uint64_t hash = 1469598103934665603ull;
+    auto mix = [&](const void* data, size_t bytes) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t b = 0; b < bytes; ++b) {
+            hash ^= p[b];
+            hash *= 1099511628211ull;
+        }
+    };
+    for (size_t id = 0; id < idToSlot.size(); ++id) {
+        const size_t i = idToSlot[id];
+        const Real state[5] = { particles.x[i], particles.y[i], particles.vx[i], particles.vy[i], particles.density[i] };
+        mix(state, sizeof(state));
+    }
+    return hash;
+}
+
+template <typename Real>
+Real BasicFluidSimulation<Real>::getKineticEnergy() {
+    return threadPool.reduce(particles.size(), 1024, Real(0),
+        [&](size_t begin, size_t end) {
+            Real sum = 0;
+            for (size_t i = begin; i < end; ++i) {
+                sum += Real(0.5) * particles.mass[i] * (particles.vx[i] * particles.vx[i] + particles.vy[i] * particles.vy[i]);
+            }
+            return sum;
+        },
+        [](Real a, Real b) { return a + b; });
+}
+
+template <typename Real>
+template <typename Weight>
+Real BasicFluidSimulation<Real>::sampleNear(Real x, Real y, Real radius, Weight&& weight) const {
+    const Real* px = particles.x.data();
+    const Real* py = particles.y.data();
+    const Real* mass = particles.mass.data();
+    Real density = 0;
+    const Real reach = queryReach(radius);
+    if (reach < 0) {
+        for (size_t j = 0; j < particles.size(); ++j) {
+            const Real dx = x - px[j];
+            const Real dy = y - py[j];
+            density += mass[j] * weight(dx * dx + dy * dy);
         }
+        return density;
     }
-    return std::max(density, EPSILON);
+    spatialGrid.forEachCandidateSpanInBox(x - reach, y - reach, x + reach, y + reach,
+                                          [&](const uint32_t* idx, size_t count) {
+        for (size_t k = 0; k < count; ++k) {
+            const size_t j = idx[k];
+            const Real dx = x - px[j];
+            const Real dy = y - py[j];
+            density += mass[j] * weight(dx * dx + dy * dy);
+        }
+    });
+    return density;
+}
+
+template <typename Real>
+Real BasicFluidSimulation<Real>::densityAt(float x, float y) const {
+    const Real density = sampleNear(static_cast<Real>(x), static_cast<Real>(y), kernels.h,
+                                    [&](Real r2) { return kernels.spikyPow2(r2); });
+    return std::max(density, Real(EPSILON));
+}
+
+template <typename Real>
+Real BasicFluidSimulation<Real>::densityAtFast(float x, float y) const {
+    // Squared distances only: Poly6 needs no sqrt, and its constants come from the cached set
+    const Real density = sampleNear(static_cast<Real>(x), static_cast<Real>(y), kernels.h,
+                                    [&](Real r2) { return kernels.poly6Density2D(r2); });
+    return std::max(density, Real(EPSILON));
+}
+
+template <typename Real>
+Real BasicFluidSimulation<Real>::densityAtFast(float x, float y, Real smoothingRadius) const {
+    if (smoothingRadius == kernels.h) return densityAtFast(x, y);
+    const SPHKernels::KernelSet<Real> k(smoothingRadius);
+    const Real density = sampleNear(static_cast<Real>(x), static_cast<Real>(y), k.h,
+                                    [&](Real r2) { return k.poly6Density2D(r2); });
+    return std::max(density, Real(EPSILON));
+}
+
+template <typename Real>
+void BasicFluidSimulation<Real>::densityAtBatch(const float* xs, const float* ys, size_t n, double* out) {
+    auto sample = [&](size_t q) {
+        out[q] = static_cast<double>(densityAtFast(xs[q], ys[q]));
+    };
+    if (queryReach(kernels.h) < 0) {
+        threadPool.parallelFor(n, kParticleGrain, [&](size_t begin, size_t end) {
+            for (size_t q = begin; q < end; ++q) sample(q);
+        });
+        return;
+    }
+
+    // Counting sort by cell key, like the grid build, so a run of queries shares one stencil
+    const size_t cells = spatialGrid.getCellCount();
+    const int gridW = spatialGrid.getWidth();
+    queryCell.resize(n);
+    queryOrder.resize(n);
+    queryStart.assign(cells + 1, 0);
+    for (size_t q = 0; q < n; ++q) {
+        const uint32_t key = static_cast<uint32_t>(spatialGrid.cellY(ys[q]) * gridW + spatialGrid.cellX(xs[q]));
+        queryCell[q] = key;
+        ++queryStart[key + 1];
+    }
+    for (size_t c = 0; c < cells; ++c) queryStart[c + 1] += queryStart[c];
+    for (size_t q = 0; q < n; ++q) queryOrder[queryStart[queryCell[q]]++] = static_cast<uint32_t>(q);
+
+    threadPool.parallelFor(n, kParticleGrain, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) sample(queryOrder[k]);
+    });
+}
+
+// Largest distance from a particle's current position to the cell it was binned in;
+// zero for a grid built at the current positions
+template <typename Real>
+void BasicFluidSimulation<Real>::measureGridDrift() {
+    const size_t N = particles.size();
+    if (spatialGrid.getCellCount() == 0 || spatialGrid.getParticleCount() != N) {
+        gridDrift = -1;
+        return;
+    }
+    const Real* px = particles.x.data();
+    const Real* py = particles.y.data();
+    gridDrift = static_cast<Real>(threadPool.reduce(N, kParticleGrain, 0.0,
+        [&](size_t begin, size_t end) { return spatialGrid.maxDrift(px, py, begin, end); },
+        [](double a, double b) { return std::max(a, b); }));
+}
+
+// Half-width of the box of cells that holds every particle within radius of a query
+// point: a particle's binned cell lies within gridDrift of where it is now. -1 = no grid.
+template <typename Real>
+Real BasicFluidSimulation<Real>::queryReach(Real radius) const {
+    if (gridDrift < 0 || spatialGrid.getParticleCount() != particles.size()) return -1;
+    return radius + gridDrift;
 }
 
 // getRestDensity() is now inline in the header
 
 // Apply mouse interaction force (positive strength = attract, negative = repel)
-void FluidSimulation::applyInteraction(const Vec2& point, double strength, double radius) {
+template <typename Real>
+void BasicFluidSimulation<Real>::applyInteraction(const Vec& point, Real strength, Real radius) {
     if (strength == 0.0 || radius <= 0.0) return;
-    const double r2 = radius * radius;
-    for (auto& p : particles) {
-        double dx = p.getX() - point.x;
-        double dy = p.getY() - point.y;
-        double dist2 = dx * dx + dy * dy;
-        if (dist2 > r2 || dist2 < EPSILON) continue;
-        double dist = std::sqrt(dist2);
-        double falloff = 1.0 - (dist / radius); // linear falloff
-        Vec2 dir(dx / dist, dy / dist);
+    const Real r2 = radius * radius;
+    for (size_t i = 0; i < particles.size(); ++i) {
+        Real dx = particles.x[i] - point.x;
+        Real dy = particles.y[i] - point.y;
+        Real dist2 = dx * dx + dy * dy;
+        if (dist2 > r2 || dist2 < Real(EPSILON)) continue;
+        Real dist = std::sqrt(dist2);
+        Real falloff = Real(1) - (dist / radius); // linear falloff
+        Vec dir(dx / dist, dy / dist);
         // Attract (strength > 0) toward point, repel (strength < 0) away from point
         // Boost interaction strength to ensure noticeable motion
-        const double boost = 5.0;
-        double fx = -strength * falloff * dir.x * boost;
-        double fy = -strength * falloff * dir.y * boost;
-        p.applyForce(fx, fy, timeStep);
+        const Real boost = 5;
+        Real fx = -strength * falloff * dir.x * boost;
+        Real fy = -strength * falloff * dir.y * boost;
+        applyForce(i, fx, fy);
     }
 }
 
 // Reset particles with custom spawn settings
-void FluidSimulation::resetParticles(int count, float spreadX, float spreadY, float originX, float originY) {
+template <typename Real>
+void BasicFluidSimulation<Real>::resetParticles(int count, float spreadX, float spreadY, float originX, float originY) {
     particles.clear();
     particles.reserve(count);
+    previousX.clear();
+    previousY.clear();
 
-    const double mass = 1.0;
+    const Real mass = 1;
     for (int i = 0; i < count; ++i) {
         // Position within the spread area centered at origin
         float x = originX + (float(rand()) / RAND_MAX - 0.5f) * spreadX;
@@ -303,41 +1263,172 @@ void FluidSimulation::resetParticles(int count, float spreadX, float spreadY, fl
         float vx = ((float(rand()) / RAND_MAX) * 2 - 1) * 0.01f;
         float vy = 0.0f;
 
-        particles.emplace_back(x, y, vx, vy, mass);
+        particles.add(x, y, vx, vy, mass);
     }
+    resetParticleIds();
+    neighborList.invalidate();
+    gridDrift = -1;
 }
 
-// -------------------- Spatial hash helpers --------------------
-FluidSimulation::CellCoord FluidSimulation::getCellCoord(double x, double y) const {
-    const double cellSize = smoothingRadius > 0.0 ? smoothingRadius : 0.1;
-    return CellCoord{ static_cast<int>(std::floor(x / cellSize)), static_cast<int>(std::floor(y / cellSize)) };
+// -------------------- Spatial grid helpers --------------------
+template <typename Real>
+void BasicFluidSimulation<Real>::buildSpatialGrid(Real minCellSize) {
+    spatialGrid.build(searchX(), searchY(), particles.size(), minCellSize,
+                      left_border, bottom_border, right_border, top_border, &threadPool);
 }
 
-void FluidSimulation::buildSpatialGrid() {
-    spatialGrid.clear();
-    const double cellSize = smoothingRadius > 0.0 ? smoothingRadius : 0.1;
-    for (size_t i = 0; i < particles.size(); ++i) {
-        const auto& p = particles[i];
-        CellCoord c = getCellCoord(p.getX(), p.getY());
-        spatialGrid[c].push_back(i);
+// Cuts the Morton-ordered cells into about kCellTasksPerThread tasks per thread of equal
+// estimated work. A cell's work is its occupancy times the occupancy of its 3x3
+// stencil, so the crowded cells along the floor become many small tasks while the
+// nearly empty upper domain folds into a few large ones.
+template <typename Real>
+void BasicFluidSimulation<Real>::buildCellTasks() {
+    cellTaskStart.clear();
+    cellTaskWeight.clear();
+    const int threads = threadPool.getThreadCount();
+    if (threads == 1) return;
+
+    const std::vector<uint32_t>& cells = spatialGrid.getMortonCellOrder();
+    const int w = spatialGrid.getWidth();
+    const int hgt = spatialGrid.getHeight();
+    auto occupancy = [&](int cx, int cy) {
+        const size_t key = static_cast<size_t>(cy) * w + cx;
+        return spatialGrid.cellEnd(key) - spatialGrid.cellBegin(key);
+    };
+    auto cellWork = [&](uint32_t key) -> uint64_t {
+        const int cx = static_cast<int>(key % w);
+        const int cy = static_cast<int>(key / w);
+        const uint32_t own = occupancy(cx, cy);
+        if (own == 0) return 0;
+        uint64_t stencil = 0;
+        for (int y = std::max(cy - 1, 0); y <= std::min(cy + 1, hgt - 1); ++y) {
+            for (int x = std::max(cx - 1, 0); x <= std::min(cx + 1, w - 1); ++x) {
+                stencil += occupancy(x, y);
+            }
+        }
+        return own * stencil;
+    };
+
+    uint64_t total = 0;
+    for (uint32_t key : cells) total += cellWork(key);
+    const uint64_t target = std::max<uint64_t>(1, total / (static_cast<uint64_t>(threads) * kCellTasksPerThread));
+
+    uint64_t weight = 0;
+    cellTaskStart.push_back(0);
+    for (size_t c = 0; c < cells.size(); ++c) {
+        weight += cellWork(cells[c]);
+        if (weight >= target || c + 1 == cells.size()) {
+            cellTaskStart.push_back(static_cast<uint32_t>(c + 1));
+            cellTaskWeight.push_back(static_cast<uint32_t>(std::min<uint64_t>(weight, UINT32_MAX)));
+            weight = 0;
+        }
+    }
+}
+
+// Grid mode bins particles every step. List mode only re-bins (with cells wide enough
+// for h + skin) when the cached lists have gone stale; Morton reordering is deferred
+// to those rebuilds because it invalidates every stored index.
+template <typename Real>
+void BasicFluidSimulation<Real>::refreshNeighbors(bool predicted, Real gridSkin) {
+    searchPredicted = predicted;
+    const bool reorderDue = reorderInterval > 0 && ++stepsSinceReorder >= reorderInterval;
+
+    if (useNeighborLists) {
+        ++neighborListSteps;
+        if (!neighborsStale(gridSkin)) return;
+    }
+    rebuildNeighbors(gridSkin, reorderDue);
+}
+
+// Whether a pair within h may be missing from the candidates at the current search
+// positions. Lists go stale once a particle moved skin / 2 since they were built. A
+// grid query visits the 3x3 cells around the query point, so with cells h + gridSkin
+// wide it still finds every particle that has left its binned cell by at most gridSkin.
+template <typename Real>
+bool BasicFluidSimulation<Real>::neighborsStale(Real gridSkin) {
+    const size_t N = particles.size();
+    if (useNeighborLists) {
+        return neighborList.needsRebuild(searchX(), searchY(), N, smoothingRadius, neighborSkin, &threadPool);
+    }
+    if (spatialGrid.getParticleCount() != N) return true;
+    const double drift = threadPool.reduce(N, 4096, 0.0,
+        [&](size_t begin, size_t end) { return spatialGrid.maxDrift(searchX(), searchY(), begin, end); },
+        [](double a, double b) { return std::max(a, b); });
+    return drift > static_cast<double>(gridSkin);
+}
+
+template <typename Real>
+void BasicFluidSimulation<Real>::rebuildNeighbors(Real gridSkin, bool reorder) {
+    const Real cellSize = smoothingRadius + (useNeighborLists ? neighborSkin : gridSkin);
+    buildSpatialGrid(cellSize);
+    if (reorder) {
+        reorderParticles();
+        buildSpatialGrid(cellSize);
     }
+    if (!useNeighborLists) return;
+    neighborList.build(searchX(), searchY(), particles.size(), spatialGrid, smoothingRadius, neighborSkin,
+                       &threadPool);
+    ++neighborListRebuilds;
+}
+
+template <typename Real>
+void BasicFluidSimulation<Real>::resetNeighborListStats() {
+    neighborListSteps = 0;
+    neighborListRebuilds = 0;
+}
+
+template <typename Real>
+void BasicFluidSimulation<Real>::setUseNeighborLists(bool enabled) {
+    if (enabled == useNeighborLists) return;
+    useNeighborLists = enabled;
+    neighborList.invalidate();
+    resetNeighborListStats();
+}
+
+template <typename Real>
+void BasicFluidSimulation<Real>::setNeighborSkin(Real skin) {
+    neighborSkin = std::max(Real(0), skin);
+    resetNeighborListStats();
 }
 
-void FluidSimulation::getNeighbors(size_t particleIndex, std::vector<size_t>& neighbors) const {
+template <typename Real>
+void BasicFluidSimulation<Real>::getNeighbors(size_t particleIndex, std::vector<size_t>& neighbors) const {
     if (particleIndex >= particles.size()) return;
     neighbors.clear();
-    const double cellSize = smoothingRadius > 0.0 ? smoothingRadius : 0.1;
-    const auto& p = particles[particleIndex];
-    CellCoord c = getCellCoord(p.getX(), p.getY());
-
-    for (int dy = -1; dy <= 1; ++dy) {
-        for (int dx = -1; dx <= 1; ++dx) {
-            CellCoord n{ c.x + dx, c.y + dy };
-            auto it = spatialGrid.find(n);
-            if (it == spatialGrid.end()) continue;
-            for (size_t idx : it->second) {
-                if (idx != particleIndex) neighbors.push_back(idx);
-            }
+    forEachNeighbor(particleIndex, [&](size_t idx) {
+        if (idx != particleIndex) neighbors.push_back(idx);
+    });
+}
+
+// -------------------- Morton reordering --------------------
+template <typename Real>
+void BasicFluidSimulation<Real>::resetParticleIds() {
+    idToSlot.resize(particles.size());
+    for (size_t i = 0; i < particles.size(); ++i) {
+        particles.id[i] = static_cast<uint32_t>(i);
+        idToSlot[i] = static_cast<uint32_t>(i);
+    }
+    stepsSinceReorder = 0;
+}
+
+// Permutes particle storage into Z-order of their grid cells. Requires a grid built
+// for the current positions; the grid must be rebuilt afterwards.
+template <typename Real>
+void BasicFluidSimulation<Real>::reorderParticles() {
+    const uint32_t* sorted = spatialGrid.getSortedIndices();
+    reorderOrder.clear();
+    for (uint32_t key : spatialGrid.getMortonCellOrder()) {
+        for (uint32_t k = spatialGrid.cellBegin(key); k < spatialGrid.cellEnd(key); ++k) {
+            reorderOrder.push_back(sorted[k]);
         }
     }
+    particles.gatherInto(reorderOrder.data(), reorderScratch);
+    particles.swap(reorderScratch);
+    for (size_t slot = 0; slot < particles.size(); ++slot) {
+        idToSlot[particles.id[slot]] = static_cast<uint32_t>(slot);
+    }
+    stepsSinceReorder = 0;
 }
+
+template class BasicFluidSimulation<float>;
+template class BasicFluidSimulation<double>;
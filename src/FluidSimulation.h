@@ -1,119 +1,359 @@
 #pragma once
+#include "SimPrecision.h"
 #include "Vec2.h"
 #include "Particle.h"
+#include "ParticleStore.h"
 #include "SPHKernels.h"
+#include "SpatialGrid.h"
+#include "NeighborList.h"
+#include "SimdKernels.h"
+#include "ThreadPool.h"
+#include "SimSnapshot.h"
+#include "SolverMode.h"
 #include <vector>
-#include <unordered_map>
 #include <algorithm>
 #include <cstdint>
 
-class FluidSimulation {
+// SPH fluid simulation core, templated on the scalar type used for particle state and
+// all physics (float or double). Both are instantiated in FluidSimulation.cpp; the app
+// uses the FluidSimulation alias from SimPrecision.h.
+template <typename Real>
+class BasicFluidSimulation {
+public:
+    using Vec = Vec2T<Real>;
+    using Store = BasicParticleStore<Real>;
+    using View = BasicParticleView<Real>;
+
 private:
-    std::vector<Particle> particles;
-    Vec2 gravity;           // Gravity vector
-    float timeStep;
-    float top_border;
-    float bottom_border;
-    float left_border;
-    float right_border;
-    float damping;
-    float velocityDrag;      // Per-step velocity drag (0-1)
-    float collisionDamping;  // Separate damping for collisions (like Unity Sim 2D)
+    Store particles;  // SoA storage used by every pass
+    Vec gravity;           // Gravity vector
+    Real timeStep;
+    // Adaptive step control: when on, each step picks dt from the CFL and force criteria
+    bool adaptiveTimeStep;
+    Real minTimeStep;
+    Real maxTimeStep;
+    Real cflNumber;         // dt <= cfl * h / max |v|
+    Real forceNumber;       // dt <= force * sqrt(h / max |a|)
+    Real currentTimeStep;   // dt of the step in progress (or the last one)
+    Real top_border;
+    Real bottom_border;
+    Real left_border;
+    Real right_border;
+    Real damping;
+    Real velocityDrag;      // Per-step velocity drag (0-1)
+    Real collisionDamping;  // Separate damping for collisions (like Unity Sim 2D)
     // SPH parameter (was a global constant); now configurable at runtime
-    double smoothingRadius;
-    double pressureMultiplier;
-    double nearPressureMultiplier;  // Near pressure multiplier for dual density SPH
-    double viscosityStrength;        // Viscosity strength constant
-    double restDensity;  // TARGET_DENSITY (rho0)
-    double maxVelocity;  // Maximum velocity clamp
-    
-    // Spatial hash for neighbor search optimization
-    struct CellCoord {
-        int x, y;
-        bool operator==(const CellCoord& other) const {
-            return x == other.x && y == other.y;
-        }
-    };
-    struct CellCoordHash {
-        std::size_t operator()(const CellCoord& c) const {
-            const uint32_t hashK1 = 15823;
-            const uint32_t hashK2 = 9737333;
-            return static_cast<uint32_t>(c.x) * hashK1 + static_cast<uint32_t>(c.y) * hashK2;
-        }
-    };
-    std::unordered_map<CellCoord, std::vector<size_t>, CellCoordHash> spatialGrid;
+    Real smoothingRadius;
+    Real pressureMultiplier;
+    Real nearPressureMultiplier;  // Near pressure multiplier for dual density SPH
+    Real viscosityStrength;        // Viscosity strength constant
+    Real restDensity;  // TARGET_DENSITY (rho0)
+    Real maxVelocity;  // Maximum velocity clamp
+    SPHKernels::KernelSet<Real> kernels;  // Kernel constants for smoothingRadius, rebuilt when it changes
     
-    // Spatial hash helper functions
-    CellCoord getCellCoord(double x, double y) const;
-    void buildSpatialGrid();
+    // Flat cell grid for neighbor search, rebuilt once per step (at searchX/searchY)
+    SpatialGrid spatialGrid;
+    void buildSpatialGrid(Real minCellSize);
     void getNeighbors(size_t particleIndex, std::vector<size_t>& neighbors) const;
+
+    // Optional Verlet neighbor lists reused across steps until particles move skin / 2
+    NeighborList neighborList;
+    bool useNeighborLists;
+    Real neighborSkin;                    // Extra radius beyond h captured by the lists
+    uint64_t neighborListSteps;           // Steps taken in list mode since the stats were reset
+    uint64_t neighborListRebuilds;        // List rebuilds over the same period
+    // The explicit and PBF steps search (and evaluate every SPH sum) at the predicted
+    // positions nx/ny; IISPH searches at x/y
+    bool searchPredicted;
+    const Real* searchX() const { return searchPredicted ? particles.nx.data() : particles.x.data(); }
+    const Real* searchY() const { return searchPredicted ? particles.ny.data() : particles.y.data(); }
+    // gridSkin widens grid-mode cells beyond h, for steps whose particles keep moving
+    // after the search (list mode always uses neighborSkin)
+    void refreshNeighbors(bool predicted, Real gridSkin = 0);
+    bool neighborsStale(Real gridSkin);
+    void rebuildNeighbors(Real gridSkin, bool reorder);
+    void resetNeighborListStats();
+
+    // Density queries walk the same grid. It was binned at searchX/searchY (or at the last
+    // list rebuild), so particles may have left their cells since; gridDrift is the largest
+    // such distance and widens each query's box to match. update() measures it as its last
+    // pass, so the const queries only read it and may run concurrently. Negative until a
+    // step has built a grid for the current particles (queries then visit every particle).
+    Real gridDrift;
+    std::vector<uint32_t> queryStart;     // densityAtBatch: counting sort of the queries by cell
+    std::vector<uint32_t> queryOrder;
+    std::vector<uint32_t> queryCell;
+    void measureGridDrift();
+    Real queryReach(Real radius) const;
+    // Sum of mass_j * weight(r2) over the particles within radius of (x, y), by the grid
+    template <typename Weight>
+    Real sampleNear(Real x, Real y, Real radius, Weight&& weight) const;
+
+    // Visits the neighbor candidates (self included) of the particle in slot i
+    template <typename Fn>
+    void forEachNeighbor(size_t i, Fn&& fn) const;
+    // Same candidates as forEachNeighbor, as contiguous index spans fn(indices, count)
+    template <typename Fn>
+    void forEachNeighborSpan(size_t i, Fn&& fn) const;
+    // Visits every unordered candidate pair (i, j), i != j, exactly once
+    template <typename Fn>
+    void forEachNeighborPair(Fn&& fn) const;
+
+    // Batched density + near density and pressure force passes; the backend is resolved
+    // against the CPU at runtime
+    SimdKernels::Backend kernelBackend;
+    void computeDensities();
+
+    // Symmetric pressure pass: each pair is evaluated once and applied equal-and-opposite
+    bool useSymmetricForces;
+    std::vector<Real> forceX;             // Per-particle force accumulators for the force passes
+    std::vector<Real> forceY;
+    void accumulatePairPressureForces();
+    // Adaptive dt from the current velocities and this step's forces (see adaptiveTimeStep)
+    Real chooseTimeStep(bool symmetric);
+
+    // Implicit incompressible SPH (IISPH) and Position Based Fluids (PBF) solvers. Their
+    // rest density is separate from the explicit one: 0 captures the mean density on the
+    // next step of either.
+    SolverMode solverMode;
+    Real implicitRestDensity;
+    int implicitMaxIterations;
+    Real implicitTolerance;               // Stop once the average compression is below this
+    int positionIterations;               // PBF constraint iterations per step (fixed)
+    int implicitIterations;               // Statistics from the last step (0 after an explicit one)
+    Real implicitDensityError;
+    Real implicitRelaxation;              // Jacobi omega carried between steps
+    struct ImplicitBuffers {              // Per-slot working arrays, reused across steps
+        std::vector<Real> advX, advY;     // Velocity after non-pressure forces
+        std::vector<Real> aii;            // Diagonal of the pressure system
+        std::vector<Real> advDensity;     // Density predicted from the advected velocities
+        std::vector<Real> wallX, wallY;   // Density gradient due to the box walls
+        std::vector<Real> pressure, nextPressure, bestPressure;
+        std::vector<Real> compression;    // PBF: relative compression of each particle
+        std::vector<Real> pressureTerm;   // p_i / rho_i^2
+        size_t pairStride = 0;            // Neighbor table: pairs of i are [i * pairStride, + pairCount[i])
+        std::vector<uint32_t> pairCount;
+        std::vector<uint32_t> pairIndex;
+        std::vector<Real> pairGradX, pairGradY;  // m_j grad W_ij
+        std::vector<Real> lambda;         // PBF: constraint multipliers
+        std::vector<Real> lambdaScale;    // PBF: 1 / (sum_k |grad_k C_i|^2 + eps)
+        std::vector<Real> deltaX, deltaY; // PBF: position corrections of one iteration
+    } implicit;
+    void stepExplicit();
+    void stepImplicit();
+    void stepPositionBased();
+    Real meanDensity();
+    // Density the box walls add at (x, y), per unit rest density, and its gradient
+    Real wallDensityAt(Real x, Real y, Real& gx, Real& gy) const;
+    // Calls fn(j, dx, dy, r) for every neighbor j != i strictly within h of particle i,
+    // measured between the given positions (dx, dy = p_i - p_j)
+    template <typename Fn>
+    void forEachNeighborWithin(const Real* px, const Real* py, size_t i, Fn&& fn) const;
+
+    // Periodic Z-order reordering of particle storage so grid neighbors are also memory neighbors
+    int reorderInterval;                  // Steps between reorders (0 = off)
+    int stepsSinceReorder;
+    std::vector<uint32_t> idToSlot;       // Inverse of particles.id
+    std::vector<uint32_t> reorderOrder;   // Reused permutation buffers
+    Store reorderScratch;
+    void reorderParticles();
+    void resetParticleIds();
+
+    // Positions at the start of the last update(), indexed by particle ID (survives reorders)
+    std::vector<Real> previousX;
+    std::vector<Real> previousY;
+
+    // Persistent workers shared by every update() phase (1 thread = fully serial). Only
+    // the thread stepping the simulation may run work on it; the render thread's density
+    // map has a pool of its own.
+    ThreadPool threadPool;
+    bool deterministic;                   // Keep results independent of the thread count
+
+    // Work-stealing tasks for the neighbor passes: runs of grid cells in Morton order,
+    // weighted by estimated pair work (cell occupancy times 3x3 stencil occupancy)
+    std::vector<uint32_t> cellTaskStart;   // Offset of each task in the Morton cell order (tasks + 1)
+    std::vector<uint32_t> cellTaskWeight;
+    void buildCellTasks();
+    // Calls fn(i) once for every particle, cell group by cell group across the pool
+    template <typename Fn>
+    void forEachParticleByCell(Fn&& fn);
 public:
-    FluidSimulation(int count);
-    FluidSimulation(int rows, int cols, float spacing, const Vec2& origin);
+    BasicFluidSimulation(int count);
+    BasicFluidSimulation(int rows, int cols, float spacing, const Vec& origin);
     void update();
     
     // Density and pressure
-    double densityOf(const Particle& particle);
-    double nearDensityOf(const Particle& particle);  // Near density calculation
-    double pressureOf(double density);
-    double nearPressureOf(double nearDensity);       // Near pressure calculation
-    double densityAt(float x, float y) const; // Density at arbitrary position
-    double densityAtFast(float x, float y, double smoothingRadius) const; // Faster variant (no sqrt)
-    Vec2 calculateGradient(const Particle& particle);
-    Vec2 calculateViscosity(const Particle& particle);  // Viscosity force calculation
-    float calculateSharedPressure(float densityA, float densityB);
-    float calculateSharedNearPressure(float nearDensityA, float nearDensityB);
+    void densitiesOf(size_t i, Real& density, Real& nearDensity);  // Scalar reference for computeDensities
+    Real pressureOf(Real density);
+    Real nearPressureOf(Real nearDensity);       // Near pressure calculation
+    Real densityAt(float x, float y) const; // Density at arbitrary position
+    Real densityAtFast(float x, float y) const; // Faster variant (Poly6 on squared distance, cached constants)
+    Real densityAtFast(float x, float y, Real smoothingRadius) const; // Same, for an arbitrary radius
+    // densityAtFast at n points into out. Queries are sorted by grid cell so neighboring
+    // points walk the same cells back to back, and run on the simulation's thread pool.
+    void densityAtBatch(const float* xs, const float* ys, size_t n, double* out);
+    Vec calculateGradient(size_t i);
+    // calculateGradient + calculateViscosity for every particle through the batched kernel (current backend)
+    void computePressureGradients(std::vector<Real>& gx, std::vector<Real>& gy);
+    Vec calculateViscosity(size_t i);  // Viscosity force (Poly6-weighted velocity differences)
+    Real calculateSharedPressure(Real densityA, Real densityB);
+    Real calculateSharedNearPressure(Real nearDensityA, Real nearDensityB);
     
     //Helper funtions
-    void resolveCollisions(Particle& pi);
+    void applyForce(size_t i, Real fx, Real fy);  // v += F / m * dt
+    void resolveCollisions(size_t i);
     
-    // Getters
-    const std::vector<Particle>& getPositions() const;
+    // Every tunable parameter as one value, and a copy of the render-facing state into
+    // a snapshot (its buffers are reused, so steady-state copies do not allocate).
+    // The snapshot's previous positions are those from before the last update().
+    BasicSimSettings<Real> getSettings() const;
+    void writeSnapshot(BasicSimSnapshot<Real>& snapshot) const;
+
+    // Getters (views stay valid until the next update or reset)
+    size_t getParticleCount() const { return particles.size(); }
+    View getParticleView() const;
+    ConstSpan<Real> getPositionsX() const { return particles.x; }
+    ConstSpan<Real> getPositionsY() const { return particles.y; }
+    ConstSpan<Real> getVelocitiesX() const { return particles.vx; }
+    ConstSpan<Real> getVelocitiesY() const { return particles.vy; }
+    ConstSpan<Real> getDensities() const { return particles.density; }
+    Particle getParticle(size_t slot) const;  // AoS copy of one slot, for tooling
+
+    // Stable particle IDs; storage order changes whenever particles are reordered
+    uint32_t getParticleId(size_t slot) const { return particles.id[slot]; }
+    size_t getParticleSlot(uint32_t id) const { return idToSlot[id]; }
+    ConstSpan<uint32_t> getParticleIds() const { return particles.id; }
+
+    // Verlet neighbor list mode access
+    bool getUseNeighborLists() const { return useNeighborLists; }
+    void setUseNeighborLists(bool enabled);
+    Real getNeighborSkin() const { return neighborSkin; }
+    void setNeighborSkin(Real skin);
+    // Neighbor list statistics: rebuilds per step in list mode (1 = rebuilt every step)
+    uint64_t getNeighborListRebuilds() const { return neighborListRebuilds; }
+    uint64_t getNeighborListSteps() const { return neighborListSteps; }
+    double getNeighborListRebuildRate() const {
+        return neighborListSteps > 0 ? static_cast<double>(neighborListRebuilds) / neighborListSteps : 0.0;
+    }
+
+    // Density / force kernel backend (Scalar, SSE2, AVX2); requests are clamped to what the CPU supports
+    SimdKernels::Backend getKernelBackend() const { return kernelBackend; }
+    void setKernelBackend(SimdKernels::Backend backend) { kernelBackend = SimdKernels::resolveBackend(backend); }
+
+    // Symmetric pair force pass access (false = per-particle gather through the batched kernel)
+    bool getUseSymmetricForces() const { return useSymmetricForces; }
+    void setUseSymmetricForces(bool enabled) { useSymmetricForces = enabled; }
+
+    // Worker thread count (caller included). The symmetric pair pass scatters into both
+    // particles of a pair, so with more than one thread (or in deterministic mode)
+    // forces use the gather pass.
+    int getThreadCount() const { return threadPool.getThreadCount(); }
+    void setThreadCount(int threads) { threadPool.setThreadCount(threads); }
+
+    // Deterministic mode: the same per-particle passes run for every thread count, so
+    // particle state is byte-identical with 1 or 64 threads (for a given SIMD backend)
+    bool getDeterministic() const { return deterministic; }
+    void setDeterministic(bool enabled) { deterministic = enabled; }
+    // FNV-1a hash of every particle's position, velocity and density in particle ID order
+    uint64_t getStateHash() const;
+    // Total kinetic energy, reduced in a fixed tree so it does not depend on the thread count.
+    // Runs on the simulation's pool, so it is not const.
+    Real getKineticEnergy();
+    // Grid from the last neighbor refresh (cells are h wide, or h + skin in list mode)
+    const SpatialGrid& getSpatialGrid() const { return spatialGrid; }
+
+    // Morton reorder interval access (0 disables reordering)
+    int getReorderInterval() const { return reorderInterval; }
+    void setReorderInterval(int k) { reorderInterval = std::max(0, k); }
     // Gravity access
-    const Vec2& getGravity() const { return gravity; }
-    void setGravity(const Vec2& g) { gravity = g; }
+    const Vec& getGravity() const { return gravity; }
+    void setGravity(const Vec& g) { gravity = g; }
 
     // Smoothing radius access
-    double getSmoothingRadius() const { return smoothingRadius; }
-    void setSmoothingRadius(double h) { smoothingRadius = std::max(1e-6, h); }
+    Real getSmoothingRadius() const { return smoothingRadius; }
+    void setSmoothingRadius(Real h) {
+        smoothingRadius = std::max(Real(1e-6), h);
+        kernels.rebuild(smoothingRadius);
+    }
+    const SPHKernels::KernelSet<Real>& getKernels() const { return kernels; }
 
     // Pressure multiplier access
-    double getPressureMultiplier() const { return pressureMultiplier; }
-    void setPressureMultiplier(double p) { pressureMultiplier = std::max(1e-6, p); }
+    Real getPressureMultiplier() const { return pressureMultiplier; }
+    void setPressureMultiplier(Real p) { pressureMultiplier = std::max(Real(1e-6), p); }
+
+    // Time step access (the fixed dt; see below for adaptive stepping)
+    Real getTimeStep() const { return timeStep; }
+    void setTimeStep(Real dt) {
+        timeStep = std::max(Real(1e-6), dt);
+        if (!adaptiveTimeStep) currentTimeStep = timeStep;
+    }
+
+    // Pressure solver. IISPH and PBF enforce incompressibility each step (stable at several
+    // times the explicit dt); their rest density, iteration counts and tolerance are their own.
+    SolverMode getSolverMode() const { return solverMode; }
+    void setSolverMode(SolverMode mode) { solverMode = mode; }
+    Real getImplicitRestDensity() const { return implicitRestDensity; }
+    void setImplicitRestDensity(Real rho) { implicitRestDensity = std::max(Real(0), rho); }
+    int getImplicitMaxIterations() const { return implicitMaxIterations; }
+    void setImplicitMaxIterations(int n) { implicitMaxIterations = std::max(1, n); }
+    Real getImplicitTolerance() const { return implicitTolerance; }
+    void setImplicitTolerance(Real t) { implicitTolerance = std::max(Real(1e-5), t); }
+    // PBF: density-constraint iterations per step; more trade time for less compression
+    int getPositionIterations() const { return positionIterations; }
+    void setPositionIterations(int n) { positionIterations = std::max(1, n); }
+    int getImplicitIterations() const { return implicitIterations; }
+    Real getImplicitDensityError() const { return implicitDensityError; }
 
-    // Time step access
-    float getTimeStep() const { return timeStep; }
-    void setTimeStep(float dt) { timeStep = std::max(1e-6f, dt); }
+    // Adaptive time step: each update() takes
+    //   dt = min(cfl * h / max|v|, force * sqrt(h / max|a|)), clamped to [min, max],
+    // so calm phases take long steps and violent ones short ones
+    bool getAdaptiveTimeStep() const { return adaptiveTimeStep; }
+    void setAdaptiveTimeStep(bool enabled) {
+        adaptiveTimeStep = enabled;
+        if (!enabled) currentTimeStep = timeStep;
+    }
+    Real getMinTimeStep() const { return minTimeStep; }
+    Real getMaxTimeStep() const { return maxTimeStep; }
+    void setTimeStepBounds(Real minDt, Real maxDt) {
+        minTimeStep = std::max(Real(1e-6), minDt);
+        maxTimeStep = std::max(minTimeStep, maxDt);
+    }
+    Real getCflNumber() const { return cflNumber; }
+    void setCflNumber(Real c) { cflNumber = std::max(Real(1e-3), c); }
+    Real getForceNumber() const { return forceNumber; }
+    void setForceNumber(Real f) { forceNumber = std::max(Real(1e-3), f); }
+    // dt used by the last update() (the fixed time step unless adaptive stepping is on)
+    Real getLastTimeStep() const { return currentTimeStep; }
 
     // Damping access
-    float getDamping() const { return damping; }
-    void setDamping(float d) { damping = std::max(0.0f, std::min(1.0f, d)); }
+    Real getDamping() const { return damping; }
+    void setDamping(Real d) { damping = std::max(Real(0), std::min(Real(1), d)); }
     // Velocity drag access
-    float getVelocityDrag() const { return velocityDrag; }
-    void setVelocityDrag(float d) { velocityDrag = std::max(0.0f, std::min(1.0f, d)); }
+    Real getVelocityDrag() const { return velocityDrag; }
+    void setVelocityDrag(Real d) { velocityDrag = std::max(Real(0), std::min(Real(1), d)); }
     
     // Collision damping access
-    float getCollisionDamping() const { return collisionDamping; }
-    void setCollisionDamping(float d) { collisionDamping = std::max(0.0f, std::min(1.0f, d)); }
+    Real getCollisionDamping() const { return collisionDamping; }
+    void setCollisionDamping(Real d) { collisionDamping = std::max(Real(0), std::min(Real(1), d)); }
 
     // Rest density access
-    double getRestDensity() const { return restDensity; }
-    void setRestDensity(double rho) { restDensity = std::max(1e-6, rho); }
+    Real getRestDensity() const { return restDensity; }
+    void setRestDensity(Real rho) { restDensity = std::max(Real(1e-6), rho); }
 
     // Near pressure multiplier access
-    double getNearPressureMultiplier() const { return nearPressureMultiplier; }
-    void setNearPressureMultiplier(double p) { nearPressureMultiplier = std::max(1e-6, p); }
+    Real getNearPressureMultiplier() const { return nearPressureMultiplier; }
+    void setNearPressureMultiplier(Real p) { nearPressureMultiplier = std::max(Real(1e-6), p); }
 
     // Viscosity strength access
-    double getViscosityStrength() const { return viscosityStrength; }
-    void setViscosityStrength(double v) { viscosityStrength = std::max(0.0, v); }
+    Real getViscosityStrength() const { return viscosityStrength; }
+    void setViscosityStrength(Real v) { viscosityStrength = std::max(Real(0), v); }
     
     // External interaction (mouse) force
-    void applyInteraction(const Vec2& point, double strength, double radius);
+    void applyInteraction(const Vec& point, Real strength, Real radius);
 
     // Max velocity access
-    double getMaxVelocity() const { return maxVelocity; }
-    void setMaxVelocity(double v) { maxVelocity = std::max(0.0, v); }
+    Real getMaxVelocity() const { return maxVelocity; }
+    void setMaxVelocity(Real v) { maxVelocity = std::max(Real(0), v); }
     
     // Reset particles with custom spawn settings
     void resetParticles(int count, float spreadX, float spreadY, float originX, float originY);
@@ -0,0 +1,104 @@
+#include "NeighborList.h"
+#include "ThreadPool.h"
+#include <atomic>
+
+namespace {
+// Particles per parallel chunk; smaller pools of work are not worth a wakeup
+constexpr size_t kParallelGrain = 512;
+}
+
+template <typename Real>
+void NeighborList::build(const Real* xs, const Real* ys, size_t n, const SpatialGrid& grid, double cutoff, double skin,
+                         ThreadPool* pool) {
+    const double r = cutoff + skin;
+    const double r2 = r * r;
+
+    // clear/resize keep capacity, so rebuilds stop allocating once the lists have grown
+    offsets.resize(n + 1);
+    indices.clear();
+    refX.resize(n);
+    refY.resize(n);
+
+    offsets[0] = 0;
+    if (pool && pool->getThreadCount() > 1 && n >= 2 * kParallelGrain) {
+        // Pass 1 counts each list, a prefix sum places them, pass 2 fills them in place
+        pool->parallelFor(n, kParallelGrain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const double xi = xs[i];
+                const double yi = ys[i];
+                uint32_t count = 0;
+                grid.forEachCandidate(xi, yi, [&](uint32_t j) {
+                    const double dx = xs[j] - xi;
+                    const double dy = ys[j] - yi;
+                    if (dx * dx + dy * dy <= r2) ++count;
+                });
+                offsets[i + 1] = count;
+                refX[i] = xi;
+                refY[i] = yi;
+            }
+        });
+        for (size_t i = 0; i < n; ++i) offsets[i + 1] += offsets[i];
+        indices.resize(offsets[n]);
+        pool->parallelFor(n, kParallelGrain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const double xi = xs[i];
+                const double yi = ys[i];
+                uint32_t* out = indices.data() + offsets[i];
+                grid.forEachCandidate(xi, yi, [&](uint32_t j) {
+                    const double dx = xs[j] - xi;
+                    const double dy = ys[j] - yi;
+                    if (dx * dx + dy * dy <= r2) *out++ = j;
+                });
+            }
+        });
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            const double xi = xs[i];
+            const double yi = ys[i];
+            grid.forEachCandidate(xi, yi, [&](uint32_t j) {
+                const double dx = xs[j] - xi;
+                const double dy = ys[j] - yi;
+                if (dx * dx + dy * dy <= r2) indices.push_back(j);
+            });
+            offsets[i + 1] = static_cast<uint32_t>(indices.size());
+            refX[i] = xi;
+            refY[i] = yi;
+        }
+    }
+
+    builtCutoff = cutoff;
+    builtSkin = skin;
+    valid = true;
+}
+
+template <typename Real>
+bool NeighborList::needsRebuild(const Real* xs, const Real* ys, size_t n, double cutoff, double skin,
+                                ThreadPool* pool) const {
+    if (!valid || n != refX.size()) return true;
+    if (cutoff != builtCutoff || skin != builtSkin) return true;
+
+    const double limit = 0.5 * skin;
+    const double limit2 = limit * limit;
+    auto movedTooFar = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const double dx = xs[i] - refX[i];
+            const double dy = ys[i] - refY[i];
+            if (dx * dx + dy * dy > limit2) return true;
+        }
+        return false;
+    };
+    if (!pool || pool->getThreadCount() == 1 || n < 2 * kParallelGrain) return movedTooFar(0, n);
+
+    std::atomic<bool> stale{false};
+    pool->parallelFor(n, kParallelGrain, [&](size_t begin, size_t end) {
+        if (!stale.load(std::memory_order_relaxed) && movedTooFar(begin, end)) {
+            stale.store(true, std::memory_order_relaxed);
+        }
+    });
+    return stale.load();
+}
+
+template void NeighborList::build<float>(const float*, const float*, size_t, const SpatialGrid&, double, double, ThreadPool*);
+template void NeighborList::build<double>(const double*, const double*, size_t, const SpatialGrid&, double, double, ThreadPool*);
+template bool NeighborList::needsRebuild<float>(const float*, const float*, size_t, double, double, ThreadPool*) const;
+template bool NeighborList::needsRebuild<double>(const double*, const double*, size_t, double, double, ThreadPool*) const;
@@ -0,0 +1,50 @@
+#pragma once
+#include "SpatialGrid.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Verlet neighbor lists: for every particle, the indices (self included) within
+// cutoff + skin at build time, stored back to back in CSR form. The lists stay valid
+// until some particle has moved more than half the skin, so they can be reused
+// across several steps instead of re-walking the grid every step.
+class NeighborList {
+private:
+    std::vector<uint32_t> offsets;   // Start of each particle's list in indices (N + 1 entries)
+    std::vector<uint32_t> indices;   // Concatenated neighbor indices
+    std::vector<double> refX;        // Positions at the last build
+    std::vector<double> refY;
+    double builtCutoff = 0.0;
+    double builtSkin = 0.0;
+    bool valid = false;
+
+public:
+    // Requires `grid` to be built with cells at least cutoff + skin wide. With a pool the
+    // lists are counted, then filled, in parallel (same result as the serial build).
+    // Both methods are instantiated for float and double positions.
+    template <typename Real>
+    void build(const Real* xs, const Real* ys, size_t n, const SpatialGrid& grid, double cutoff, double skin,
+               ThreadPool* pool = nullptr);
+
+    // True when the particle count or radii changed, or any particle moved more than skin / 2
+    template <typename Real>
+    bool needsRebuild(const Real* xs, const Real* ys, size_t n, double cutoff, double skin,
+                      ThreadPool* pool = nullptr) const;
+    void invalidate() { valid = false; }
+
+    size_t getPairCount() const { return indices.size(); }
+
+    template <typename Fn>
+    void forEach(size_t i, Fn&& fn) const {
+        const uint32_t end = offsets[i + 1];
+        for (uint32_t k = offsets[i]; k < end; ++k) {
+            fn(indices[k]);
+        }
+    }
+
+    // Hands the whole list of particle i to fn(indices, count) as one span
+    template <typename Fn>
+    void forEachSpan(size_t i, Fn&& fn) const {
+        fn(indices.data() + offsets[i], static_cast<size_t>(offsets[i + 1] - offsets[i]));
+    }
+};
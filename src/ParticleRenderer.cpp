@@ -124,7 +124,7 @@ void ParticleRenderer::cleanup() {
     }
 }
 
-void ParticleRenderer::draw(const std::vector<Particle>& particles, double maxVelocity) {
+void ParticleRenderer::draw(const ParticleView& particles, double maxVelocity) {
     if (particles.empty()) return;
 
     // Extract positions and colors from particles
@@ -138,26 +138,26 @@ void ParticleRenderer::draw(const std::vector<Particle>& particles, double maxVe
     if (useVelocityColor && maxVel <= 0.0f) {
         // Fallback: calculate max velocity if not provided
         maxVel = 0.01f; // minimum threshold
-        for (const auto& particle : particles) {
-            float vx = static_cast<float>(particle.getVx());
-            float vy = static_cast<float>(particle.getVy());
+        for (size_t i = 0; i < particles.size(); ++i) {
+            float vx = static_cast<float>(particles.vx[i]);
+            float vy = static_cast<float>(particles.vy[i]);
             float vel = std::sqrt(vx * vx + vy * vy);
             if (vel > maxVel) maxVel = vel;
         }
         if (maxVel < 0.01f) maxVel = 0.01f; // prevent division by zero
     }
     
-    for (const auto& particle : particles) {
+    for (size_t i = 0; i < particles.size(); ++i) {
         // Position
-        float x = particle.getX();
-        float y = particle.getY();
+        float x = static_cast<float>(particles.x[i]);
+        float y = static_cast<float>(particles.y[i]);
         positions.push_back(x);
         positions.push_back(y);
         
         // Color based on velocity if enabled
         if (useVelocityColor && maxVel > 0.0f) {
-            float vx = static_cast<float>(particle.getVx());
-            float vy = static_cast<float>(particle.getVy());
+            float vx = static_cast<float>(particles.vx[i]);
+            float vy = static_cast<float>(particles.vy[i]);
             float vel = std::sqrt(vx * vx + vy * vy);
             float normalizedVel = std::min(1.0f, vel / maxVel);
             
@@ -1,6 +1,6 @@
 #pragma once
 #include <vector>
-#include "Particle.h"
+#include "ParticleStore.h"
 #include <glad/glad.h>
 
 // Handles rendering of particles with optional velocity-based coloring
@@ -29,6 +29,6 @@ public:
     void setUseVelocityColor(bool enabled) { useVelocityColor = enabled; }
     bool getUseVelocityColor() const { return useVelocityColor; }
     
-    void draw(const std::vector<Particle>& particles, double maxVelocity = 0.0);
+    void draw(const ParticleView& particles, double maxVelocity = 0.0);
 };
 
@@ -0,0 +1,110 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "SimPrecision.h"
+
+// Minimal read-only view over a contiguous array (std::span is C++20)
+template <typename T>
+class ConstSpan {
+private:
+    const T* ptr = nullptr;
+    size_t count = 0;
+
+public:
+    ConstSpan() = default;
+    ConstSpan(const T* data, size_t size) : ptr(data), count(size) {}
+    ConstSpan(const std::vector<T>& v) : ptr(v.data()), count(v.size()) {}
+
+    const T* data() const { return ptr; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T& operator[](size_t i) const { return ptr[i]; }
+    const T* begin() const { return ptr; }
+    const T* end() const { return ptr + count; }
+};
+
+// Read-only view of the particle fields renderers need
+template <typename Real>
+struct BasicParticleView {
+    ConstSpan<Real> x, y;
+    ConstSpan<Real> vx, vy;
+    size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+};
+
+// Structure-of-arrays particle storage: one contiguous array per field, so each pass
+// streams only the fields it touches (the density pass reads positions and mass only).
+template <typename Real>
+struct BasicParticleStore {
+    std::vector<Real> x, y;             // Position
+    std::vector<Real> vx, vy;           // Velocity
+    std::vector<Real> nx, ny;           // Predicted position
+    std::vector<Real> mass;
+    std::vector<Real> density;
+    std::vector<Real> nearDensity;      // Near density (for dual density SPH)
+    std::vector<Real> pressure;
+    std::vector<uint8_t> active;        // Whether particle is active/alive
+    std::vector<uint32_t> id;           // Stable ID, preserved across reorders
+
+    size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+
+    void clear() {
+        x.clear(); y.clear(); vx.clear(); vy.clear(); nx.clear(); ny.clear();
+        mass.clear(); density.clear(); nearDensity.clear(); pressure.clear();
+        active.clear(); id.clear();
+    }
+
+    void reserve(size_t n) {
+        x.reserve(n); y.reserve(n); vx.reserve(n); vy.reserve(n); nx.reserve(n); ny.reserve(n);
+        mass.reserve(n); density.reserve(n); nearDensity.reserve(n); pressure.reserve(n);
+        active.reserve(n); id.reserve(n);
+    }
+
+    void resize(size_t n) {
+        x.resize(n); y.resize(n); vx.resize(n); vy.resize(n); nx.resize(n); ny.resize(n);
+        mass.resize(n); density.resize(n); nearDensity.resize(n); pressure.resize(n);
+        active.resize(n); id.resize(n);
+    }
+
+    // Appends an active particle with zeroed density terms; its ID is its initial slot
+    void add(Real px, Real py, Real pvx, Real pvy, Real pmass) {
+        id.push_back(static_cast<uint32_t>(x.size()));
+        x.push_back(px); y.push_back(py);
+        vx.push_back(pvx); vy.push_back(pvy);
+        nx.push_back(px); ny.push_back(py);
+        mass.push_back(pmass);
+        density.push_back(0);
+        nearDensity.push_back(0);
+        pressure.push_back(0);
+        active.push_back(1);
+    }
+
+    // Writes particles order[0..n) of this store into `out` slots 0..n
+    void gatherInto(const uint32_t* order, BasicParticleStore& out) const {
+        const size_t n = size();
+        out.resize(n);
+        for (size_t k = 0; k < n; ++k) {
+            const uint32_t s = order[k];
+            out.x[k] = x[s]; out.y[k] = y[s];
+            out.vx[k] = vx[s]; out.vy[k] = vy[s];
+            out.nx[k] = nx[s]; out.ny[k] = ny[s];
+            out.mass[k] = mass[s];
+            out.density[k] = density[s];
+            out.nearDensity[k] = nearDensity[s];
+            out.pressure[k] = pressure[s];
+            out.active[k] = active[s];
+            out.id[k] = id[s];
+        }
+    }
+
+    void swap(BasicParticleStore& other) {
+        x.swap(other.x); y.swap(other.y); vx.swap(other.vx); vy.swap(other.vy);
+        nx.swap(other.nx); ny.swap(other.ny); mass.swap(other.mass);
+        density.swap(other.density); nearDensity.swap(other.nearDensity);
+        pressure.swap(other.pressure); active.swap(other.active); id.swap(other.id);
+    }
+};
+
+using ParticleView = BasicParticleView<SimReal>;
@@ -1,6 +1,6 @@
 // Renderer.cpp
 #include "Renderer.h"
-#include "FluidSimulation.h"
+#include "SimulationThread.h"
 #include "ParticleRenderer.h"
 #include "DensityMapRenderer.h"
 #include "UIControls.h"
@@ -88,12 +88,12 @@ void Renderer::beginFrame() {
     ImGui::NewFrame();
 }
 
-void Renderer::drawParticles(const std::vector<Particle>& particles, double maxVelocity) {
+void Renderer::drawParticles(const ParticleView& particles, double maxVelocity) {
     particleRenderer->setUseVelocityColor(uiControls->getUseVelocityColor());
     particleRenderer->draw(particles, maxVelocity);
 }
 
-void Renderer::drawDensityMap(const FluidSimulation& sim) {
+void Renderer::drawDensityMap(const SimSnapshot& snapshot) {
     densityMapRenderer->setEnabled(uiControls->getShowDensityMap());
     
     // Update resolution if needed
@@ -106,8 +106,10 @@ void Renderer::drawDensityMap(const FluidSimulation& sim) {
     if (newW != densityMapRenderer->getWidth() || newH != densityMapRenderer->getHeight()) {
         densityMapRenderer->setResolution(newW, newH);
     }
+    densityMapRenderer->setUpdateInterval(uiControls->getDensityUpdateInterval());
+    densityMapRenderer->setDirtyTiles(uiControls->getDensityDirtyTiles(), uiControls->getDensityDirtyThreshold());
     
-    densityMapRenderer->draw(sim);
+    densityMapRenderer->draw(snapshot);
 }
 
 void Renderer::endFrame() {
@@ -144,7 +146,7 @@ void Renderer::cleanup() {
     glfwTerminate();
 }
 
-void Renderer::drawGui(FluidSimulation& sim) {
+void Renderer::drawGui(SimulationThread& sim) {
     uiControls->drawGui(sim);
 }
 
@@ -1,12 +1,13 @@
 #pragma once
 #include <vector>
 #include "Vec2.h"
-#include "Particle.h"
+#include "ParticleStore.h"
+#include "SimPrecision.h"
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
-// Forward declarations
-class FluidSimulation;
+// Forward declarations (SimSnapshot comes from SimPrecision.h)
+class SimulationThread;
 class ParticleRenderer;
 class DensityMapRenderer;
 class UIControls;
@@ -30,14 +31,14 @@ public:
     
     bool init();
     void beginFrame();
-    void drawParticles(const std::vector<Particle>& particles, double maxVelocity = 0.0);
-    void drawDensityMap(const FluidSimulation& sim);
+    void drawParticles(const ParticleView& particles, double maxVelocity = 0.0);
+    void drawDensityMap(const SimSnapshot& snapshot);
     void endFrame();
     bool shouldClose();
     void cleanup();
     
     // GUI
-    void drawGui(FluidSimulation& sim);
+    void drawGui(SimulationThread& sim);
     
     // Mouse interaction
     bool getInteraction(Vec2& point, float& strength, float& radius);
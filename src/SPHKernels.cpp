@@ -1,4 +1,5 @@
 #include "SPHKernels.h"
+#include <algorithm>
 
 namespace {
 // Pi constant local to this TU
@@ -7,45 +8,123 @@ constexpr double kPi = 3.14159265358979323846;
 
 namespace SPHKernels {
 
-double spikyPow2(double h, double distance) {
-    if (distance > h || h <= 0.0) return 0.0;
+template <typename Real>
+Real spikyPow2(Real h, Real distance) {
+    if (distance > h || h <= Real(0)) return 0;
     // Matches previous implementation: (h - r)^2 / (pi * h^4 / 6)
-    double volume = kPi * std::pow(h, 4) / 6.0;
-    double t = (h - distance);
+    Real volume = static_cast<Real>(kPi) * (h * h * h * h) / Real(6);
+    Real t = (h - distance);
     return (t * t) / volume;
 }
 
-double spikyPow2Derivative(float h, float distance) {
-    if (distance > h || h <= 0.0f) return 0.0;
+template <typename Real>
+Real spikyPow2Derivative(Real h, Real distance) {
+    if (distance > h || h <= Real(0)) return 0;
     // Derivative of above w.r.t distance
-    float scale = 12.0f / (static_cast<float>(kPi) * std::pow(h, 4));
+    Real scale = Real(12) / (static_cast<Real>(kPi) * (h * h * h * h));
     return (distance - h) * scale;
 }
 
-double spikyPow3(double h, double distance) {
-    if (distance > h || h <= 0.0) return 0.0;
+template <typename Real>
+Real spikyPow3(Real h, Real distance) {
+    if (distance > h || h <= Real(0)) return 0;
     // Common form: (h - r)^3 / (pi * h^6)
-    double volume = kPi * std::pow(h, 6);
-    double t = (h - distance);
+    Real volume = static_cast<Real>(kPi) * (h * h * h * h * h * h);
+    Real t = (h - distance);
     return (t * t * t) / volume;
 }
 
-double spikyPow3Derivative(double h, double distance) {
-    if (distance > h || h <= 0.0) return 0.0;
-    double volume = kPi * std::pow(h, 6);
-    double t = (h - distance);
+template <typename Real>
+Real spikyPow3Derivative(Real h, Real distance) {
+    if (distance > h || h <= Real(0)) return 0;
+    Real volume = static_cast<Real>(kPi) * (h * h * h * h * h * h);
+    Real t = (h - distance);
     // d/dr of (h - r)^3 / volume = -3(h - r)^2 / volume
-    return -3.0 * t * t / volume;
+    return Real(-3) * t * t / volume;
 }
 
-double poly6(double h, double distance) {
-    if (distance >= h || h <= 0.0) return 0.0;
+template <typename Real>
+Real poly6(Real h, Real distance) {
+    if (distance >= h || h <= Real(0)) return 0;
     // Classic poly6: 315/(64*pi*h^9) * (h^2 - r^2)^3
-    double h2 = h * h;
-    double t = h2 - distance * distance;
-    const double factor = 315.0 / (64.0 * kPi * std::pow(h, 9));
+    Real h2 = h * h;
+    Real t = h2 - distance * distance;
+    const Real factor = Real(315) / (Real(64) * static_cast<Real>(kPi) * (h2 * h2 * h2 * h2 * h));
     return factor * t * t * t;
 }
 
-} // namespace SPHKernels
+namespace {
+// Half-plane integrals of the unit-radius Spiky power 2 kernel W(r) = 6 / pi (1 - r)^2,
+// sampled at q = k / kHalfPlaneSamples. The slope at q is minus the integral of W along
+// the chord x = q; the fraction integrates the slopes from q = 1 inwards.
+constexpr int kHalfPlaneSamples = 256;
+struct HalfPlaneTable {
+    double fraction[kHalfPlaneSamples + 1];
+    double slope[kHalfPlaneSamples + 1];
+    HalfPlaneTable() {
+        const int chordSteps = 512;
+        for (int k = 0; k <= kHalfPlaneSamples; ++k) {
+            const double q = static_cast<double>(k) / kHalfPlaneSamples;
+            const double half = std::sqrt(std::max(0.0, 1.0 - q * q));
+            double chord = 0;
+            for (int s = 0; s < chordSteps; ++s) {  // Midpoint rule over y in [0, half]
+                const double y = (s + 0.5) * half / chordSteps;
+                const double t = 1.0 - std::sqrt(q * q + y * y);
+                chord += t > 0 ? t * t : 0.0;
+            }
+            slope[k] = -2.0 * chord * (half / chordSteps) * 6.0 / kPi;
+        }
+        fraction[kHalfPlaneSamples] = 0;
+        for (int k = kHalfPlaneSamples; k > 0; --k) {
+            fraction[k - 1] = fraction[k] - 0.5 * (slope[k] + slope[k - 1]) / kHalfPlaneSamples;
+        }
+    }
+};
+} // namespace
 
+template <typename Real>
+void spikyPow2HalfPlane(Real q, Real& fraction, Real& slope) {
+    static const HalfPlaneTable table;
+    if (q >= Real(1)) {
+        fraction = 0;
+        slope = 0;
+        return;
+    }
+    const double u = std::max(0.0, static_cast<double>(q)) * kHalfPlaneSamples;
+    const int k = std::min(static_cast<int>(u), kHalfPlaneSamples - 1);
+    const double t = u - k;
+    fraction = static_cast<Real>(table.fraction[k] + (table.fraction[k + 1] - table.fraction[k]) * t);
+    slope = static_cast<Real>(table.slope[k] + (table.slope[k + 1] - table.slope[k]) * t);
+}
+
+template <typename Real>
+void KernelSet<Real>::rebuild(Real radius) {
+    const Real pi = static_cast<Real>(kPi);
+    h = radius;
+    h2 = h * h;
+    invH = Real(1) / h;
+    const Real h4 = h2 * h2;
+    const Real h6 = h4 * h2;
+    const Real h8 = h4 * h4;
+    spikyPow2Scale = Real(6) / (pi * h4);
+    spikyPow2DerivScale = Real(12) / (pi * h4);
+    spikyPow3Scale = Real(1) / (pi * h6);
+    spikyPow3DerivScale = Real(3) / (pi * h6);
+    poly6Scale = Real(315) / (Real(64) * pi * h8 * h);
+    poly6Scale2D = Real(4) / (pi * h8);
+}
+
+#define SPH_INSTANTIATE_KERNELS(Real)                        \
+    template Real spikyPow2<Real>(Real, Real);               \
+    template Real spikyPow2Derivative<Real>(Real, Real);     \
+    template Real spikyPow3<Real>(Real, Real);               \
+    template Real spikyPow3Derivative<Real>(Real, Real);     \
+    template Real poly6<Real>(Real, Real);                   \
+    template void spikyPow2HalfPlane<Real>(Real, Real&, Real&); \
+    template struct KernelSet<Real>;
+
+SPH_INSTANTIATE_KERNELS(float)
+SPH_INSTANTIATE_KERNELS(double)
+#undef SPH_INSTANTIATE_KERNELS
+
+} // namespace SPHKernels
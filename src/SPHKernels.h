@@ -1,17 +1,134 @@
 #pragma once
 #include <cmath>
+#include <cstddef>
+#include <algorithm>
 
 // Collection of SPH kernel helpers, grouped to keep FluidSimulation lean.
+// Instantiated for float and double (see SimPrecision.h).
 namespace SPHKernels {
 // Spiky (power 2) kernel used for density (matches previous smoothingKernel)
-double spikyPow2(double h, double distance);
-double spikyPow2Derivative(float h, float distance);
+template <typename Real> Real spikyPow2(Real h, Real distance);
+template <typename Real> Real spikyPow2Derivative(Real h, Real distance);
 
 // Spiky power 3 variant (often used for “near” density / pressure)
-double spikyPow3(double h, double distance);
-double spikyPow3Derivative(double h, double distance);
+template <typename Real> Real spikyPow3(Real h, Real distance);
+template <typename Real> Real spikyPow3Derivative(Real h, Real distance);
 
 // Poly6 kernel (classic SPH) useful for viscosity or density sampling
-double poly6(double h, double distance);
-} // namespace SPHKernels
+template <typename Real> Real poly6(Real h, Real distance);
+
+// Share of the Spiky power 2 kernel's mass lying beyond a straight wall q * h away
+// (0.5 at q = 0, 0 for q >= 1), and its derivative d fraction / dq (<= 0). A wall of
+// rest density rho0 adds rho0 * fraction to a particle's density. Tabulated on first use.
+template <typename Real> void spikyPow2HalfPlane(Real q, Real& fraction, Real& slope);
+
+// Normalization constants and powers of h for one smoothing radius. Rebuilt only when
+// h changes, so the evaluations below are a few multiplies (plus a sqrt for the spiky
+// kernels) with no pow calls. All take the squared distance r2 and return 0 outside h.
+template <typename Real>
+struct KernelSet {
+    Real h = 0;
+    Real h2 = 0;
+    Real invH = 0;
+    Real spikyPow2Scale = 0;       // 6 / (pi h^4)
+    Real spikyPow2DerivScale = 0;  // 12 / (pi h^4)
+    Real spikyPow3Scale = 0;       // 1 / (pi h^6)
+    Real spikyPow3DerivScale = 0;  // 3 / (pi h^6)
+    Real poly6Scale = 0;           // 315 / (64 pi h^9), same as poly6()
+    Real poly6Scale2D = 0;         // 4 / (pi h^8), 2D-normalized Poly6 used for density sampling
+
+    KernelSet() = default;
+    explicit KernelSet(Real radius) { rebuild(radius); }
+    void rebuild(Real radius);
+
+    Real spikyPow2(Real r2) const {
+        if (r2 >= h2) return 0;
+        const Real t = h - std::sqrt(r2);
+        return t * t * spikyPow2Scale;
+    }
+    Real spikyPow2Derivative(Real r2) const { return spikyPow2DerivativeAt(r2 < h2 ? std::sqrt(r2) : h); }
+    // Same as spikyPow2Derivative for callers that already have the distance r
+    Real spikyPow2DerivativeAt(Real r) const { return r < h ? (r - h) * spikyPow2DerivScale : Real(0); }
 
+    Real spikyPow3(Real r2) const {
+        if (r2 >= h2) return 0;
+        const Real t = h - std::sqrt(r2);
+        return t * t * t * spikyPow3Scale;
+    }
+    Real spikyPow3Derivative(Real r2) const { return spikyPow3DerivativeAt(r2 < h2 ? std::sqrt(r2) : h); }
+    Real spikyPow3DerivativeAt(Real r) const {
+        if (r >= h) return 0;
+        const Real t = h - r;
+        return -t * t * spikyPow3DerivScale;
+    }
+
+    Real poly6(Real r2) const {
+        const Real t = h2 - r2;
+        return t > 0 ? t * t * t * poly6Scale : Real(0);
+    }
+    Real poly6Density2D(Real r2) const {
+        const Real t = h2 - r2;
+        return t > 0 ? t * t * t * poly6Scale2D : Real(0);
+    }
+};
+// Brute-force Poly6 density at (x, y) over n mass points; callers clamp the result
+template <typename Real>
+Real sampleDensity2D(const KernelSet<Real>& k, const Real* xs, const Real* ys, const Real* mass, size_t n,
+                     Real x, Real y) {
+    Real density = 0;
+    for (size_t j = 0; j < n; ++j) {
+        const Real dx = x - xs[j];
+        const Real dy = y - ys[j];
+        density += mass[j] * k.poly6Density2D(dx * dx + dy * dy);
+    }
+    return density;
+}
+
+// Index range [lo, hi) of the evenly spaced, ascending samples g[0..count) that can lie
+// within h of p; one sample of slack on each side absorbs rounding
+template <typename Real>
+void sampleSpan(const Real* g, size_t count, Real p, Real h, size_t& lo, size_t& hi) {
+    if (count < 2) {
+        lo = 0;
+        hi = count;
+        return;
+    }
+    const Real step = g[1] - g[0];
+    const Real first = std::floor((p - h - g[0]) / step);
+    const Real last = std::ceil((p + h - g[0]) / step) + 1;
+    lo = first <= 0 ? 0 : std::min(count, static_cast<size_t>(first));
+    hi = last <= 0 ? 0 : std::min(count, static_cast<size_t>(last));
+}
+
+// Scatter form of sampleDensity2D over a grid of sample points (gx[i], gy[j]), both axes
+// evenly spaced and ascending: each particle adds mass * Poly6 only to the samples within
+// h of it, for rows [rowBegin, rowEnd) and columns [colBegin, colEnd) of the row-major out
+// (width w), which the caller zeroes. Contributions arrive in particle order, so every
+// sample's sum is bit-identical to sampleDensity2D at that point; disjoint rectangles can
+// be filled concurrently.
+template <typename Real>
+void splatDensity2D(const KernelSet<Real>& k, const Real* xs, const Real* ys, const Real* mass, size_t n,
+                    const Real* gx, size_t w, const Real* gy, size_t rows, size_t rowBegin, size_t rowEnd,
+                    size_t colBegin, size_t colEnd, Real* out) {
+    for (size_t j = 0; j < n; ++j) {
+        size_t rowLo, rowHi;
+        sampleSpan(gy, rows, ys[j], k.h, rowLo, rowHi);
+        rowLo = std::max(rowLo, rowBegin);
+        rowHi = std::min(rowHi, rowEnd);
+        if (rowLo >= rowHi) continue;
+        size_t colLo, colHi;
+        sampleSpan(gx, w, xs[j], k.h, colLo, colHi);
+        colLo = std::max(colLo, colBegin);
+        colHi = std::min(colHi, colEnd);
+        if (colLo >= colHi) continue;
+        for (size_t r = rowLo; r < rowHi; ++r) {
+            const Real dy = gy[r] - ys[j];
+            Real* row = out + r * w;
+            for (size_t c = colLo; c < colHi; ++c) {
+                const Real dx = gx[c] - xs[j];
+                row[c] += mass[j] * k.poly6Density2D(dx * dx + dy * dy);
+            }
+        }
+    }
+}
+} // namespace SPHKernels
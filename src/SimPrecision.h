@@ -0,0 +1,19 @@
+#pragma once
+
+// Compile-time precision policy for the simulation core. BasicFluidSimulation,
+// SPHKernels and Vec2T are parameterized on the scalar type; both float and double
+// engines are instantiated, and SimReal picks the one the application runs.
+// Build with -DSPH_USE_FLOAT to run the app on the all-float engine.
+#if defined(SPH_USE_FLOAT)
+using SimReal = float;
+#else
+using SimReal = double;
+#endif
+
+template <typename Real> class BasicFluidSimulation;
+using FluidSimulation = BasicFluidSimulation<SimReal>;
+
+template <typename Real> struct BasicSimSettings;
+template <typename Real> struct BasicSimSnapshot;
+using SimSettings = BasicSimSettings<SimReal>;
+using SimSnapshot = BasicSimSnapshot<SimReal>;
@@ -0,0 +1,116 @@
+#pragma once
+#include "SimPrecision.h"
+#include "ParticleStore.h"
+#include "SPHKernels.h"
+#include "SimdKernels.h"
+#include "SolverMode.h"
+#include "Vec2.h"
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// Every user-tunable simulation parameter as one plain value, so the UI can read a
+// consistent copy without touching the simulation while it runs on another thread
+template <typename Real>
+struct BasicSimSettings {
+    Vec2T<Real> gravity;
+    Real smoothingRadius = 0;
+    Real pressureMultiplier = 0;
+    Real nearPressureMultiplier = 0;
+    Real viscosityStrength = 0;
+    Real maxVelocity = 0;
+    Real timeStep = 0;
+    bool adaptiveTimeStep = false;
+    Real minTimeStep = 0;
+    Real maxTimeStep = 0;
+    Real cflNumber = 0;
+    Real forceNumber = 0;
+    Real damping = 0;
+    Real velocityDrag = 0;
+    Real collisionDamping = 0;
+    Real restDensity = 0;
+    Real neighborSkin = 0;
+    int reorderInterval = 0;
+    bool useNeighborLists = false;
+    bool useSymmetricForces = false;
+    bool deterministic = false;
+    SimdKernels::Backend kernelBackend = SimdKernels::Backend::Scalar;
+    SolverMode solverMode = SolverMode::Explicit;
+    Real implicitRestDensity = 0;
+    int implicitMaxIterations = 0;
+    Real implicitTolerance = 0;
+    int positionIterations = 0;
+    int threadCount = 1;
+};
+
+// Immutable copy of what the renderer and UI need from one simulation step. The sim
+// thread fills one in place (reusing its buffers) and publishes it; readers never
+// see a snapshot that is still being written.
+template <typename Real>
+struct BasicSimSnapshot {
+    std::vector<Real> x, y;
+    std::vector<Real> prevX, prevY;      // Positions before the last step, same slot order
+    std::vector<Real> vx, vy;
+    std::vector<Real> mass;
+    std::vector<uint32_t> id;            // Stable particle ID of each slot (slots move on reorder)
+    BasicSimSettings<Real> settings;
+    SPHKernels::KernelSet<Real> kernels;
+    uint64_t step = 0;                   // Updates completed when the snapshot was taken
+    uint64_t commandsApplied = 0;        // Queued commands the sim had applied by then
+    uint64_t neighborListRebuilds = 0;
+    uint64_t neighborListSteps = 0;
+    Real lastTimeStep = 0;               // dt of the last step (differs from settings under adaptive stepping)
+    int implicitIterations = 0;          // Pressure iterations of the last implicit step
+    Real implicitDensityError = 0;       // Its average relative compression
+
+    // Frame pacing: the wall-clock time (seconds on the producer's clock) this state
+    // stands for, and the wall time one step covers (0 = unpaced, no interpolation)
+    double stateTime = 0;
+    double stepWallTime = 0;
+    int substeps = 0;                    // Steps run in the batch that produced this snapshot
+    double droppedTime = 0;              // Wall time discarded so far by the substep cap
+
+    size_t size() const { return x.size(); }
+    BasicParticleView<Real> view() const { return BasicParticleView<Real>{ x, y, vx, vy }; }
+
+    // Positions blended between the previous and current step (alpha 0 = previous,
+    // 1 = current) into xs/ys; the view also carries the current velocities
+    BasicParticleView<Real> interpolatedView(Real alpha, std::vector<Real>& xs, std::vector<Real>& ys) const {
+        const size_t n = size();
+        xs.resize(n);
+        ys.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            xs[i] = prevX[i] + (x[i] - prevX[i]) * alpha;
+            ys[i] = prevY[i] + (y[i] - prevY[i]) * alpha;
+        }
+        return BasicParticleView<Real>{ xs, ys, vx, vy };
+    }
+
+    // Same sampling as BasicFluidSimulation::densityAtFast, over the snapshot positions
+    Real densityAtFast(float px, float py) const {
+        const Real density = SPHKernels::sampleDensity2D(kernels, x.data(), y.data(), mass.data(), size(),
+                                                         static_cast<Real>(px), static_cast<Real>(py));
+        return std::max(density, Real(1e-6));
+    }
+    // densityAtFast at every sample (gx[i], gy[j]) of rows [rowBegin, rowEnd), by splatting
+    // each particle into the samples within h of it; out is row-major with width w
+    void densityGrid(const Real* gx, size_t w, const Real* gy, size_t rows, size_t rowBegin, size_t rowEnd,
+                     Real* out) const {
+        densityRect(gx, w, gy, rows, rowBegin, rowEnd, 0, w, out);
+    }
+    // densityGrid restricted to columns [colBegin, colEnd); the rest of out is untouched
+    void densityRect(const Real* gx, size_t w, const Real* gy, size_t rows, size_t rowBegin, size_t rowEnd,
+                     size_t colBegin, size_t colEnd, Real* out) const {
+        for (size_t r = rowBegin; r < rowEnd; ++r) {
+            std::fill(out + r * w + colBegin, out + r * w + colEnd, Real(0));
+        }
+        SPHKernels::splatDensity2D(kernels, x.data(), y.data(), mass.data(), size(), gx, w, gy, rows,
+                                   rowBegin, rowEnd, colBegin, colEnd, out);
+        for (size_t r = rowBegin; r < rowEnd; ++r) {
+            for (Real* d = out + r * w + colBegin; d != out + r * w + colEnd; ++d) *d = std::max(*d, Real(1e-6));
+        }
+    }
+    double getNeighborListRebuildRate() const {
+        return neighborListSteps > 0 ? static_cast<double>(neighborListRebuilds) / neighborListSteps : 0.0;
+    }
+};
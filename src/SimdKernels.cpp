@@ -0,0 +1,245 @@
+#include "SimdKernelsImpl.h"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SPH_SIMD_X86 1
+#endif
+
+#if defined(SPH_SIMD_X86) && defined(__GNUC__)
+#define SPH_SIMD_HAVE_AVX2 1
+#endif
+
+namespace SimdKernels {
+namespace {
+
+// Scalar fallback: plain per-neighbor loops that reject candidates outside h before the
+// square root, like densitiesOf and calculateGradient. The lane-generic bodies would pay
+// for the root, the masking and the divides on every candidate, at width 1.
+template <typename Real>
+void scalarDensity(const DensityInput<Real>& in, Real xi, Real yi,
+                   const uint32_t* idx, size_t count, Real& density, Real& nearDensity) {
+    const Real h2 = in.h * in.h;
+    Real acc2 = 0;
+    Real acc3 = 0;
+    for (size_t k = 0; k < count; ++k) {
+        const uint32_t j = idx[k];
+        const Real dx = in.x[j] - xi;
+        const Real dy = in.y[j] - yi;
+        const Real r2 = dx * dx + dy * dy;
+        if (r2 >= h2) continue;
+        const Real t = in.h - std::sqrt(r2);
+        const Real mt2 = in.mass[j] * t * t;
+        acc2 += mt2;
+        acc3 += mt2 * t;
+    }
+    density += in.pow2Scale * acc2;
+    nearDensity += in.pow3Scale * acc3;
+}
+
+template <typename Real>
+void scalarPressureForce(const ForceInput<Real>& in, size_t i,
+                         const uint32_t* idx, size_t count, Real& fx, Real& fy) {
+    const Real xi = in.x[i];
+    const Real yi = in.y[i];
+    const Real h2 = in.h * in.h;
+    const Real pi = in.pressure[i];
+    const Real pni = in.nearDensity ? in.nearPressureMultiplier * in.nearDensity[i] : Real(0);
+    const Real rhoI = in.density[i];
+    Real accX = 0;
+    Real accY = 0;
+    for (size_t k = 0; k < count; ++k) {
+        const uint32_t j = idx[k];
+        const Real dx = xi - in.x[j];
+        const Real dy = yi - in.y[j];
+        const Real r2 = dx * dx + dy * dy;
+        if (r2 >= h2 || r2 <= 0) continue;
+        const Real r = std::sqrt(r2);
+        const Real t = in.h - r;
+        Real w = t * in.slopeScale * (pi + in.pressure[j]) * Real(0.5);
+        if (in.nearDensity) {
+            w += t * t * in.nearSlopeScale * (pni + in.nearPressureMultiplier * in.nearDensity[j]) * Real(0.5);
+        }
+        const Real m = in.mass[j];
+        const Real rhoJ = in.density[j];
+        const Real scale = w * m / (rhoJ * r);
+        accX += dx * scale;
+        accY += dy * scale;
+        if (in.vx) {
+            const Real q = h2 - r2;
+            const Real wv = q * q * q * in.viscosityScale * m * (rhoI + rhoI) / (rhoI + rhoJ);
+            accX += (in.vx[j] - in.vx[i]) * wv;
+            accY += (in.vy[j] - in.vy[i]) * wv;
+        }
+    }
+    fx += accX;
+    fy += accY;
+}
+
+#ifdef SPH_SIMD_X86
+// SSE2 is part of the x86-64 baseline, so these need no runtime check there
+struct F4 {
+    using Scalar = float;
+    using Mask = __m128;
+    static constexpr int width = 4;
+    __m128 v;
+
+    static F4 zero() { return {_mm_setzero_ps()}; }
+    static F4 broadcast(float s) { return {_mm_set1_ps(s)}; }
+    static F4 gather(const float* base, const uint32_t* idx) {
+        return {_mm_setr_ps(base[idx[0]], base[idx[1]], base[idx[2]], base[idx[3]])};
+    }
+    static Mask firstLanes(int n) {
+        return _mm_cmplt_ps(_mm_setr_ps(0, 1, 2, 3), _mm_set1_ps(static_cast<float>(n)));
+    }
+    static F4 select(Mask m, F4 a) { return {_mm_and_ps(m, a.v)}; }
+    static F4 max(F4 a, F4 b) { return {_mm_max_ps(a.v, b.v)}; }
+    static F4 sqrt(F4 a) { return {_mm_sqrt_ps(a.v)}; }
+    static F4 rsqrt(F4 a) {
+        // Hardware estimate (12 bits) refined by one Newton step to ~23 bits
+        const __m128 y = _mm_rsqrt_ps(a.v);
+        const __m128 ayy = _mm_mul_ps(_mm_mul_ps(a.v, y), y);
+        return {_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), y), _mm_sub_ps(_mm_set1_ps(3.0f), ayy))};
+    }
+    static Mask less(F4 a, F4 b) { return _mm_cmplt_ps(a.v, b.v); }
+    static Mask maskAnd(Mask a, Mask b) { return _mm_and_ps(a, b); }
+    static float sum(F4 a) {
+        __m128 s = _mm_add_ps(a.v, _mm_movehl_ps(a.v, a.v));
+        s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+        return _mm_cvtss_f32(s);
+    }
+};
+
+inline F4 operator+(F4 a, F4 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline F4 operator-(F4 a, F4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline F4 operator*(F4 a, F4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline F4 operator/(F4 a, F4 b) { return {_mm_div_ps(a.v, b.v)}; }
+
+struct D2 {
+    using Scalar = double;
+    using Mask = __m128d;
+    static constexpr int width = 2;
+    __m128d v;
+
+    static D2 zero() { return {_mm_setzero_pd()}; }
+    static D2 broadcast(double s) { return {_mm_set1_pd(s)}; }
+    static D2 gather(const double* base, const uint32_t* idx) {
+        return {_mm_setr_pd(base[idx[0]], base[idx[1]])};
+    }
+    static Mask firstLanes(int n) {
+        return _mm_cmplt_pd(_mm_setr_pd(0, 1), _mm_set1_pd(n));
+    }
+    static D2 select(Mask m, D2 a) { return {_mm_and_pd(m, a.v)}; }
+    static D2 max(D2 a, D2 b) { return {_mm_max_pd(a.v, b.v)}; }
+    static D2 sqrt(D2 a) { return {_mm_sqrt_pd(a.v)}; }
+    static D2 rsqrt(D2 a) { return {_mm_div_pd(_mm_set1_pd(1.0), _mm_sqrt_pd(a.v))}; }
+    static Mask less(D2 a, D2 b) { return _mm_cmplt_pd(a.v, b.v); }
+    static Mask maskAnd(Mask a, Mask b) { return _mm_and_pd(a, b); }
+    static double sum(D2 a) { return _mm_cvtsd_f64(_mm_add_sd(a.v, _mm_unpackhi_pd(a.v, a.v))); }
+};
+
+inline D2 operator+(D2 a, D2 b) { return {_mm_add_pd(a.v, b.v)}; }
+inline D2 operator-(D2 a, D2 b) { return {_mm_sub_pd(a.v, b.v)}; }
+inline D2 operator*(D2 a, D2 b) { return {_mm_mul_pd(a.v, b.v)}; }
+inline D2 operator/(D2 a, D2 b) { return {_mm_div_pd(a.v, b.v)}; }
+
+template <typename Real> struct SseBatch;
+template <> struct SseBatch<float> { using type = F4; };
+template <> struct SseBatch<double> { using type = D2; };
+#endif
+
+bool cpuHasAvx2() {
+#ifdef SPH_SIMD_HAVE_AVX2
+    static const bool has = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    }();
+    return has;
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
+bool isSupported(Backend backend) {
+    switch (backend) {
+        case Backend::Scalar: return true;
+#ifdef SPH_SIMD_X86
+        case Backend::SSE: return true;
+#endif
+        case Backend::AVX2: return cpuHasAvx2();
+        default: return false;
+    }
+}
+
+Backend bestSupportedBackend() {
+    if (isSupported(Backend::AVX2)) return Backend::AVX2;
+    if (isSupported(Backend::SSE)) return Backend::SSE;
+    return Backend::Scalar;
+}
+
+Backend resolveBackend(Backend requested) {
+    if (isSupported(requested)) return requested;
+    return (requested == Backend::AVX2 && isSupported(Backend::SSE)) ? Backend::SSE : Backend::Scalar;
+}
+
+const char* backendName(Backend backend) {
+    switch (backend) {
+        case Backend::SSE: return "SSE2";
+        case Backend::AVX2: return "AVX2";
+        default: return "Scalar";
+    }
+}
+
+template <typename Real>
+void accumulateDensity(Backend backend, const DensityInput<Real>& in, Real xi, Real yi,
+                       const uint32_t* idx, size_t count, Real& density, Real& nearDensity) {
+    switch (backend) {
+#ifdef SPH_SIMD_HAVE_AVX2
+        case Backend::AVX2:
+            avx2::accumulateDensity(in, xi, yi, idx, count, density, nearDensity);
+            return;
+#endif
+#ifdef SPH_SIMD_X86
+        case Backend::SSE:
+            densityKernel<typename SseBatch<Real>::type>(in, xi, yi, idx, count, density, nearDensity);
+            return;
+#endif
+        default:
+            scalarDensity(in, xi, yi, idx, count, density, nearDensity);
+            return;
+    }
+}
+
+template void accumulateDensity<float>(Backend, const DensityInput<float>&, float, float,
+                                       const uint32_t*, size_t, float&, float&);
+template void accumulateDensity<double>(Backend, const DensityInput<double>&, double, double,
+                                        const uint32_t*, size_t, double&, double&);
+
+template <typename Real>
+void accumulatePressureForce(Backend backend, const ForceInput<Real>& in, size_t i,
+                             const uint32_t* idx, size_t count, Real& fx, Real& fy) {
+    switch (backend) {
+#ifdef SPH_SIMD_HAVE_AVX2
+        case Backend::AVX2:
+            avx2::accumulatePressureForce(in, i, idx, count, fx, fy);
+            return;
+#endif
+#ifdef SPH_SIMD_X86
+        case Backend::SSE:
+            pressureForce<typename SseBatch<Real>::type>(in, i, idx, count, fx, fy);
+            return;
+#endif
+        default:
+            scalarPressureForce(in, i, idx, count, fx, fy);
+            return;
+    }
+}
+
+template void accumulatePressureForce<float>(Backend, const ForceInput<float>&, size_t,
+                                             const uint32_t*, size_t, float&, float&);
+template void accumulatePressureForce<double>(Backend, const ForceInput<double>&, size_t,
+                                              const uint32_t*, size_t, double&, double&);
+
+} // namespace SimdKernels
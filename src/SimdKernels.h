@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Vectorized SPH neighbor kernels with runtime CPU dispatch. Every kernel exists as a
+// scalar fallback, an SSE2 version (4 float / 2 double lanes) and an AVX2 version
+// (8 float / 4 double lanes). The AVX2 code lives in its own translation unit and is
+// only called after the CPU reports support, so one binary runs on older x86 machines.
+namespace SimdKernels {
+
+enum class Backend { Scalar = 0, SSE = 1, AVX2 = 2 };
+
+bool isSupported(Backend backend);
+Backend bestSupportedBackend();
+// Clamps a requested backend to the best one this CPU/build supports
+Backend resolveBackend(Backend requested);
+const char* backendName(Backend backend);
+
+// Inputs shared by all density evaluations of one step
+template <typename Real>
+struct DensityInput {
+    const Real* x;        // Positions the density is measured at (SoA)
+    const Real* y;
+    const Real* mass;
+    Real h;               // Smoothing radius
+    Real pow2Scale;       // Spiky pow2 normalization, 6 / (pi h^4)
+    Real pow3Scale;       // Spiky pow3 normalization, 1 / (pi h^6)
+};
+
+// Adds the density (spiky pow2) and near density (spiky pow3) contributions of
+// neighbors idx[0..count) around (xi, yi) in one pass. Lanes at or beyond h are masked
+// out, so candidate lists may contain particles outside the kernel support.
+// The backend must be supported (see resolveBackend). Instantiated for float and double.
+template <typename Real>
+void accumulateDensity(Backend backend, const DensityInput<Real>& in, Real xi, Real yi,
+                       const uint32_t* idx, size_t count, Real& density, Real& nearDensity);
+
+// Inputs shared by all pressure force evaluations of one step
+template <typename Real>
+struct ForceInput {
+    const Real* x;        // Positions the forces act between (SoA)
+    const Real* y;
+    const Real* mass;
+    const Real* density;
+    const Real* pressure;       // Per-particle pressure, already clamped at zero
+    const Real* nearDensity;    // Null disables the near pressure term
+    Real nearPressureMultiplier;
+    Real h;                     // Smoothing radius
+    Real slopeScale;            // Spiky pow2 derivative scale, 12 / (pi h^4)
+    Real nearSlopeScale;        // Spiky pow3 derivative scale, 3 / (pi h^6)
+    const Real* vx;             // Velocities; null disables the viscosity term
+    const Real* vy;
+    Real viscosityScale;        // Viscosity strength times the 2D Poly6 scale, 4 / (pi h^8)
+};
+
+// Adds the pressure (and, if enabled, near pressure and viscosity) force on particle i
+// from neighbors idx[0..count) to (fx, fy); same quantity as calculateGradient plus
+// calculateViscosity, before the division by rho_i. Lanes at
+// or beyond h and coincident particles (including i itself) are masked out. One
+// reciprocal square root per lane gives both the distance and the direction.
+template <typename Real>
+void accumulatePressureForce(Backend backend, const ForceInput<Real>& in, size_t i,
+                             const uint32_t* idx, size_t count, Real& fx, Real& fy);
+
+} // namespace SimdKernels
@@ -0,0 +1,132 @@
+// AVX2 + FMA versions of the SimdKernels. Only this file is compiled for AVX2 (via a
+// target pragma, so no global -mavx2 flag is needed); the dispatcher in
+// SimdKernels.cpp calls into it after checking the CPU at runtime.
+#include "SimdKernels.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+// Included after the target pragma so the generic kernel bodies are compiled for AVX2
+#include "SimdKernelsImpl.h"
+
+namespace SimdKernels {
+namespace {
+
+struct F8 {
+    using Scalar = float;
+    using Mask = __m256;
+    static constexpr int width = 8;
+    __m256 v;
+
+    static F8 zero() { return {_mm256_setzero_ps()}; }
+    static F8 broadcast(float s) { return {_mm256_set1_ps(s)}; }
+    static F8 gather(const float* base, const uint32_t* idx) {
+        const __m256i vi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx));
+        return {_mm256_i32gather_ps(base, vi, 4)};
+    }
+    static Mask firstLanes(int n) {
+        const __m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+        return _mm256_cmp_ps(lane, _mm256_set1_ps(static_cast<float>(n)), _CMP_LT_OQ);
+    }
+    static F8 select(Mask m, F8 a) { return {_mm256_and_ps(m, a.v)}; }
+    static F8 max(F8 a, F8 b) { return {_mm256_max_ps(a.v, b.v)}; }
+    static F8 sqrt(F8 a) { return {_mm256_sqrt_ps(a.v)}; }
+    static F8 rsqrt(F8 a) {
+        // Hardware estimate (12 bits) refined by one Newton step to ~23 bits
+        const __m256 y = _mm256_rsqrt_ps(a.v);
+        const __m256 hy = _mm256_mul_ps(_mm256_set1_ps(0.5f), y);
+        const __m256 ayy = _mm256_mul_ps(_mm256_mul_ps(a.v, y), y);
+        return {_mm256_mul_ps(hy, _mm256_sub_ps(_mm256_set1_ps(3.0f), ayy))};
+    }
+    static Mask less(F8 a, F8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+    static Mask maskAnd(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+    static float sum(F8 a) {
+        __m128 s = _mm_add_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1));
+        s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+        s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+        return _mm_cvtss_f32(s);
+    }
+};
+
+inline F8 operator+(F8 a, F8 b) { return {_mm256_add_ps(a.v, b.v)}; }
+inline F8 operator-(F8 a, F8 b) { return {_mm256_sub_ps(a.v, b.v)}; }
+inline F8 operator*(F8 a, F8 b) { return {_mm256_mul_ps(a.v, b.v)}; }
+inline F8 operator/(F8 a, F8 b) { return {_mm256_div_ps(a.v, b.v)}; }
+
+struct D4 {
+    using Scalar = double;
+    using Mask = __m256d;
+    static constexpr int width = 4;
+    __m256d v;
+
+    static D4 zero() { return {_mm256_setzero_pd()}; }
+    static D4 broadcast(double s) { return {_mm256_set1_pd(s)}; }
+    static D4 gather(const double* base, const uint32_t* idx) {
+        const __m128i vi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(idx));
+        // The masked form, so the gather's pass-through source is defined (all lanes load)
+        const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+        return {_mm256_mask_i32gather_pd(_mm256_setzero_pd(), base, vi, all, 8)};
+    }
+    static Mask firstLanes(int n) {
+        const __m256d lane = _mm256_setr_pd(0, 1, 2, 3);
+        return _mm256_cmp_pd(lane, _mm256_set1_pd(n), _CMP_LT_OQ);
+    }
+    static D4 select(Mask m, D4 a) { return {_mm256_and_pd(m, a.v)}; }
+    static D4 max(D4 a, D4 b) { return {_mm256_max_pd(a.v, b.v)}; }
+    static D4 sqrt(D4 a) { return {_mm256_sqrt_pd(a.v)}; }
+    static D4 rsqrt(D4 a) { return {_mm256_div_pd(_mm256_set1_pd(1.0), _mm256_sqrt_pd(a.v))}; }
+    static Mask less(D4 a, D4 b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ); }
+    static Mask maskAnd(Mask a, Mask b) { return _mm256_and_pd(a, b); }
+    static double sum(D4 a) {
+        __m128d s = _mm_add_pd(_mm256_castpd256_pd128(a.v), _mm256_extractf128_pd(a.v, 1));
+        s = _mm_add_sd(s, _mm_unpackhi_pd(s, s));
+        return _mm_cvtsd_f64(s);
+    }
+};
+
+inline D4 operator+(D4 a, D4 b) { return {_mm256_add_pd(a.v, b.v)}; }
+inline D4 operator-(D4 a, D4 b) { return {_mm256_sub_pd(a.v, b.v)}; }
+inline D4 operator*(D4 a, D4 b) { return {_mm256_mul_pd(a.v, b.v)}; }
+inline D4 operator/(D4 a, D4 b) { return {_mm256_div_pd(a.v, b.v)}; }
+
+} // namespace
+
+namespace avx2 {
+
+void accumulateDensity(const DensityInput<float>& in, float xi, float yi,
+                       const uint32_t* idx, size_t count, float& density, float& nearDensity) {
+    densityKernel<F8>(in, xi, yi, idx, count, density, nearDensity);
+}
+
+void accumulateDensity(const DensityInput<double>& in, double xi, double yi,
+                       const uint32_t* idx, size_t count, double& density, double& nearDensity) {
+    densityKernel<D4>(in, xi, yi, idx, count, density, nearDensity);
+}
+
+void accumulatePressureForce(const ForceInput<float>& in, size_t i,
+                             const uint32_t* idx, size_t count, float& fx, float& fy) {
+    pressureForce<F8>(in, i, idx, count, fx, fy);
+}
+
+void accumulatePressureForce(const ForceInput<double>& in, size_t i,
+                             const uint32_t* idx, size_t count, double& fx, double& fy) {
+    pressureForce<D4>(in, i, idx, count, fx, fy);
+}
+
+} // namespace avx2
+} // namespace SimdKernels
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif // x86 && GNUC
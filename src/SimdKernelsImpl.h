@@ -0,0 +1,158 @@
+#pragma once
+// Internal to the SimdKernels translation units: lane-width-generic kernel bodies.
+// Each ISA supplies a batch type B with
+//   Scalar, Mask, width, zero(), broadcast(s), gather(base, idx), firstLanes(n),
+//   select(mask, v), maskAnd(a, b), less(a, b), max(a, b), sqrt(v), rsqrt(v), sum(v)
+//   and the + - * / operators,
+// and instantiates the kernels below with it. Everything here has internal linkage
+// so the AVX2 instantiations can never be picked for another translation unit.
+#include "SimdKernels.h"
+
+namespace SimdKernels {
+
+// AVX2 entry points, defined in SimdKernelsAVX2.cpp when the build targets x86
+namespace avx2 {
+void accumulateDensity(const DensityInput<float>& in, float xi, float yi,
+                       const uint32_t* idx, size_t count, float& density, float& nearDensity);
+void accumulateDensity(const DensityInput<double>& in, double xi, double yi,
+                       const uint32_t* idx, size_t count, double& density, double& nearDensity);
+void accumulatePressureForce(const ForceInput<float>& in, size_t i,
+                             const uint32_t* idx, size_t count, float& fx, float& fy);
+void accumulatePressureForce(const ForceInput<double>& in, size_t i,
+                             const uint32_t* idx, size_t count, double& fx, double& fy);
+} // namespace avx2
+
+namespace {
+
+template <typename B>
+void densityKernel(const DensityInput<typename B::Scalar>& in,
+                   typename B::Scalar xi, typename B::Scalar yi,
+                   const uint32_t* idx, size_t count,
+                   typename B::Scalar& density, typename B::Scalar& nearDensity) {
+    constexpr int W = B::width;
+    const B vxi = B::broadcast(xi);
+    const B vyi = B::broadcast(yi);
+    const B vh = B::broadcast(in.h);
+    B acc2 = B::zero();
+    B acc3 = B::zero();
+
+    auto accumulate = [&](const uint32_t* lanes, const typename B::Mask* live) {
+        const B dx = B::gather(in.x, lanes) - vxi;
+        const B dy = B::gather(in.y, lanes) - vyi;
+        const B r = B::sqrt(dx * dx + dy * dy);
+        // (h - r) clamped at zero masks every lane outside the kernel support
+        B t = B::max(vh - r, B::zero());
+        if (live) t = B::select(*live, t);
+        const B mt2 = B::gather(in.mass, lanes) * t * t;
+        acc2 = acc2 + mt2;
+        acc3 = acc3 + mt2 * t;
+    };
+
+    size_t k = 0;
+    for (; k + W <= count; k += W) {
+        accumulate(idx + k, nullptr);
+    }
+    if (k < count) {
+        // Tail: pad with a valid index and mask the padded lanes off
+        uint32_t lanes[W];
+        const int rem = static_cast<int>(count - k);
+        for (int l = 0; l < W; ++l) lanes[l] = idx[k + (l < rem ? l : 0)];
+        const typename B::Mask live = B::firstLanes(rem);
+        accumulate(lanes, &live);
+    }
+
+    density += in.pow2Scale * B::sum(acc2);
+    nearDensity += in.pow3Scale * B::sum(acc3);
+}
+
+template <typename B, bool WithNear, bool WithViscosity>
+void pressureForceKernel(const ForceInput<typename B::Scalar>& in, size_t i,
+                         const uint32_t* idx, size_t count,
+                         typename B::Scalar& fx, typename B::Scalar& fy) {
+    using Scalar = typename B::Scalar;
+    using Mask = typename B::Mask;
+    constexpr int W = B::width;
+    const B vxi = B::broadcast(in.x[i]);
+    const B vyi = B::broadcast(in.y[i]);
+    const B vh = B::broadcast(in.h);
+    const B vh2 = B::broadcast(in.h * in.h);
+    const B half = B::broadcast(Scalar(0.5));
+    const B vpi = B::broadcast(in.pressure[i]);
+    const B vslope = B::broadcast(in.slopeScale);
+    const B vpni = B::broadcast(WithNear ? in.nearPressureMultiplier * in.nearDensity[i] : Scalar(0));
+    const B vnearMul = B::broadcast(in.nearPressureMultiplier);
+    const B vnearSlope = B::broadcast(in.nearSlopeScale);
+    const B vvxi = B::broadcast(WithViscosity ? in.vx[i] : Scalar(0));
+    const B vvyi = B::broadcast(WithViscosity ? in.vy[i] : Scalar(0));
+    const B vviscosity = B::broadcast(in.viscosityScale);
+    const B vrhoi = B::broadcast(WithViscosity ? in.density[i] : Scalar(0));
+    B accX = B::zero();
+    B accY = B::zero();
+
+    auto accumulate = [&](const uint32_t* lanes, const Mask* live) {
+        const B dx = vxi - B::gather(in.x, lanes);
+        const B dy = vyi - B::gather(in.y, lanes);
+        const B r2 = dx * dx + dy * dy;
+        Mask inside = B::maskAnd(B::less(r2, vh2), B::less(B::zero(), r2));
+        if (live) inside = B::maskAnd(inside, *live);
+        // Zeroing 1/r on dead lanes keeps r = 0 (self) from producing inf * 0
+        const B invR = B::select(inside, B::rsqrt(r2));
+        const B t = B::select(inside, vh - r2 * invR);   // h - r
+        const B m = B::gather(in.mass, lanes);
+
+        // -dW/dr * m_j * shared pressure / rho_j, with dW/dr = -(h - r) * slopeScale; the
+        // near term uses dWnear/dr = -(h - r)^2 * nearSlopeScale over the same rho_j
+        const B shared = (vpi + B::gather(in.pressure, lanes)) * half;
+        B w = t * vslope * shared;
+        if (WithNear) {
+            const B sharedNear = (vpni + vnearMul * B::gather(in.nearDensity, lanes)) * half;
+            w = w + t * t * vnearSlope * sharedNear;
+        }
+        const B rhoJ = B::gather(in.density, lanes);
+        const B scale = w * (m / rhoJ) * invR;
+        accX = accX + dx * scale;
+        accY = accY + dy * scale;
+        if (WithViscosity) {
+            // mu * m_j * 2 rho_i / (rho_i + rho_j) * (v_j - v_i) * Poly6(r), on the r2 already at hand
+            const B q = B::select(inside, vh2 - r2);
+            const B wv = q * q * q * vviscosity * m * (vrhoi + vrhoi) / (vrhoi + rhoJ);
+            accX = accX + (B::gather(in.vx, lanes) - vvxi) * wv;
+            accY = accY + (B::gather(in.vy, lanes) - vvyi) * wv;
+        }
+    };
+
+    size_t k = 0;
+    for (; k + W <= count; k += W) {
+        accumulate(idx + k, nullptr);
+    }
+    if (k < count) {
+        uint32_t lanes[W];
+        const int rem = static_cast<int>(count - k);
+        for (int l = 0; l < W; ++l) lanes[l] = idx[k + (l < rem ? l : 0)];
+        const Mask live = B::firstLanes(rem);
+        accumulate(lanes, &live);
+    }
+
+    fx += B::sum(accX);
+    fy += B::sum(accY);
+}
+
+template <typename B>
+void pressureForce(const ForceInput<typename B::Scalar>& in, size_t i,
+                   const uint32_t* idx, size_t count,
+                   typename B::Scalar& fx, typename B::Scalar& fy) {
+    if (in.vx) {
+        if (in.nearDensity) {
+            pressureForceKernel<B, true, true>(in, i, idx, count, fx, fy);
+        } else {
+            pressureForceKernel<B, false, true>(in, i, idx, count, fx, fy);
+        }
+    } else if (in.nearDensity) {
+        pressureForceKernel<B, true, false>(in, i, idx, count, fx, fy);
+    } else {
+        pressureForceKernel<B, false, false>(in, i, idx, count, fx, fy);
+    }
+}
+
+} // namespace
+} // namespace SimdKernels
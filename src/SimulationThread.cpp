@@ -0,0 +1,356 @@
+#include "SimulationThread.h"
+#include <algorithm>
+#include <cmath>
+
+static const double kMaxSleep = 0.01;  // Seconds
+
+SimulationThread::SimulationThread(FluidSimulation& sim)
+    : sim(sim), settings(sim.getSettings()) {}
+
+SimulationThread::~SimulationThread() {
+    stop();
+}
+
+void SimulationThread::start() {
+    if (running.load(std::memory_order_relaxed)) return;
+    settings = sim.getSettings();
+    epoch = std::chrono::steady_clock::now();
+    publishSnapshot(0.0, 0.0, 0);
+    snapshots.acquire();
+    running.store(true, std::memory_order_release);
+    thread = std::thread([this] { run(); });
+}
+
+void SimulationThread::stop() {
+    running.store(false, std::memory_order_release);
+    if (thread.joinable()) thread.join();
+}
+
+double SimulationThread::now() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+// Wall time one step stands for; 0 when steps are not paced at all
+double SimulationThread::stepWallTime() const {
+    if (realTime.load(std::memory_order_relaxed)) {
+        return static_cast<double>(sim.getLastTimeStep()) / timeScale.load(std::memory_order_relaxed);
+    }
+    const int rate = stepsPerSecond.load(std::memory_order_relaxed);
+    return rate > 0 ? 1.0 / rate : 0.0;
+}
+
+void SimulationThread::run() {
+    double last = now();
+    double accumulator = 0;
+    while (running.load(std::memory_order_acquire)) {
+        applyCommands();
+
+        const double current = now();
+        accumulator += current - last;
+        last = current;
+        const int cap = maxSubsteps.load(std::memory_order_relaxed);
+        int steps = 0;
+        // Under adaptive stepping the next dt is only known once the step has run, so the
+        // last dt decides whether a step is due and the actual one is paid for afterwards
+        double stepWall = stepWallTime();
+        if (stepWall > 0) {
+            while (steps < cap && accumulator >= stepWall) {
+                step();
+                ++steps;
+                stepWall = stepWallTime();
+                accumulator -= stepWall;
+            }
+            // Spiral-of-death guard: whatever the cap could not cover is dropped
+            if (steps == cap && accumulator >= stepWall) {
+                droppedTime += accumulator - std::fmod(accumulator, stepWall);
+                accumulator = std::fmod(accumulator, stepWall);
+            }
+        } else {
+            step();
+            steps = 1;
+            accumulator = 0;
+        }
+        // The newest state stands for the moment the accumulator was last empty
+        if (steps > 0) publishSnapshot(current - accumulator, stepWall, steps);
+
+        // Sleep until the next step is due, waking at least every kMaxSleep so commands
+        // and stop() are not held up by very slow time scales
+        if (stepWall > 0 && accumulator < stepWall) {
+            const double wake = current + std::min(stepWall - accumulator, kMaxSleep);
+            std::this_thread::sleep_until(epoch + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(wake)));
+        }
+    }
+}
+
+void SimulationThread::step() {
+    if (interactActive) {
+        sim.applyInteraction(interactPoint, interactStrength, interactRadius);
+    }
+    sim.update();
+    ++stepCount;
+}
+
+void SimulationThread::applyCommands() {
+    SimCommand command;
+    while (commands.pop(command)) {
+        applyCommand(command);
+        ++commandsApplied;
+    }
+}
+
+void SimulationThread::applyCommand(const SimCommand& command) {
+    using Type = SimCommand::Type;
+    const Real a = static_cast<Real>(command.a);
+    switch (command.type) {
+        case Type::SetGravity: sim.setGravity(Vec(a, static_cast<Real>(command.b))); break;
+        case Type::SetSmoothingRadius: sim.setSmoothingRadius(a); break;
+        case Type::SetPressureMultiplier: sim.setPressureMultiplier(a); break;
+        case Type::SetNearPressureMultiplier: sim.setNearPressureMultiplier(a); break;
+        case Type::SetViscosityStrength: sim.setViscosityStrength(a); break;
+        case Type::SetMaxVelocity: sim.setMaxVelocity(a); break;
+        case Type::SetTimeStep: sim.setTimeStep(a); break;
+        case Type::SetAdaptiveTimeStep: sim.setAdaptiveTimeStep(command.i != 0); break;
+        case Type::SetTimeStepBounds: sim.setTimeStepBounds(a, static_cast<Real>(command.b)); break;
+        case Type::SetCflNumber: sim.setCflNumber(a); break;
+        case Type::SetForceNumber: sim.setForceNumber(a); break;
+        case Type::SetDamping: sim.setDamping(a); break;
+        case Type::SetCollisionDamping: sim.setCollisionDamping(a); break;
+        case Type::SetRestDensity: sim.setRestDensity(a); break;
+        case Type::SetUseNeighborLists: sim.setUseNeighborLists(command.i != 0); break;
+        case Type::SetNeighborSkin: sim.setNeighborSkin(a); break;
+        case Type::SetUseSymmetricForces: sim.setUseSymmetricForces(command.i != 0); break;
+        case Type::SetReorderInterval: sim.setReorderInterval(command.i); break;
+        case Type::SetKernelBackend: sim.setKernelBackend(static_cast<SimdKernels::Backend>(command.i)); break;
+        case Type::SetThreadCount: sim.setThreadCount(command.i); break;
+        case Type::SetDeterministic: sim.setDeterministic(command.i != 0); break;
+        case Type::SetSolverMode: sim.setSolverMode(static_cast<SolverMode>(command.i)); break;
+        case Type::SetImplicitRestDensity: sim.setImplicitRestDensity(a); break;
+        case Type::SetImplicitMaxIterations: sim.setImplicitMaxIterations(command.i); break;
+        case Type::SetImplicitTolerance: sim.setImplicitTolerance(a); break;
+        case Type::SetPositionIterations: sim.setPositionIterations(command.i); break;
+        case Type::SetInteraction:
+            interactActive = command.i != 0;
+            interactPoint = Vec(a, static_cast<Real>(command.b));
+            interactStrength = static_cast<Real>(command.c);
+            interactRadius = static_cast<Real>(command.d);
+            break;
+        case Type::ResetParticles:
+            sim.resetParticles(command.i, static_cast<float>(command.a), static_cast<float>(command.b),
+                               static_cast<float>(command.c), static_cast<float>(command.d));
+            break;
+    }
+}
+
+void SimulationThread::publishSnapshot(double stateTime, double stepWallTime, int substeps) {
+    SimSnapshot& snapshot = snapshots.writeBuffer();
+    sim.writeSnapshot(snapshot);
+    snapshot.step = stepCount;
+    snapshot.commandsApplied = commandsApplied;
+    snapshot.stateTime = stateTime;
+    snapshot.stepWallTime = stepWallTime;
+    snapshot.substeps = substeps;
+    snapshot.droppedTime = droppedTime;
+    snapshots.publish();
+}
+
+double SimulationThread::interpolationAlpha(const SimSnapshot& snapshot) const {
+    if (snapshot.stepWallTime <= 0) return 1.0;
+    const double alpha = (now() - snapshot.stateTime) / snapshot.stepWallTime;
+    return std::max(0.0, std::min(1.0, alpha));
+}
+
+const SimSnapshot& SimulationThread::acquireSnapshot() {
+    if (snapshots.acquire()) {
+        const SimSnapshot& snapshot = snapshots.readBuffer();
+        // Only adopt the simulation's settings once it has seen every change made here,
+        // otherwise a slider would jump back to a value it was just moved away from
+        if (snapshot.commandsApplied == commandsPushed) settings = snapshot.settings;
+    }
+    return snapshots.readBuffer();
+}
+
+void SimulationThread::push(const SimCommand& command) {
+    // The queue only fills if the sim thread stalls; wait for it rather than drop input
+    while (!commands.push(command)) std::this_thread::yield();
+    ++commandsPushed;
+}
+
+void SimulationThread::pushValue(SimCommand::Type type, double value) {
+    SimCommand command{type};
+    command.a = value;
+    push(command);
+}
+
+void SimulationThread::pushFlag(SimCommand::Type type, int value) {
+    SimCommand command{type};
+    command.i = value;
+    push(command);
+}
+
+void SimulationThread::setInteraction(bool active, const Vec2& point, float strength, float radius) {
+    // Held buttons re-send only when something changed; the sim keeps applying the last one
+    if (!active && !lastInteractActive) return;
+    SimCommand command{SimCommand::Type::SetInteraction};
+    command.i = active ? 1 : 0;
+    if (active) {
+        command.a = point.x;
+        command.b = point.y;
+        command.c = strength;
+        command.d = radius;
+    }
+    lastInteractActive = active;
+    if (command.i == lastInteraction.i && command.a == lastInteraction.a && command.b == lastInteraction.b &&
+        command.c == lastInteraction.c && command.d == lastInteraction.d) {
+        return;
+    }
+    lastInteraction = command;
+    push(command);
+}
+
+void SimulationThread::resetParticles(int count, float spreadX, float spreadY, float originX, float originY) {
+    SimCommand command{SimCommand::Type::ResetParticles};
+    command.i = count;
+    command.a = spreadX;
+    command.b = spreadY;
+    command.c = originX;
+    command.d = originY;
+    push(command);
+}
+
+void SimulationThread::setGravity(const Vec& g) {
+    settings.gravity = g;
+    SimCommand command{SimCommand::Type::SetGravity};
+    command.a = g.x;
+    command.b = g.y;
+    push(command);
+}
+
+void SimulationThread::setSmoothingRadius(Real h) {
+    settings.smoothingRadius = h;
+    pushValue(SimCommand::Type::SetSmoothingRadius, h);
+}
+
+void SimulationThread::setPressureMultiplier(Real p) {
+    settings.pressureMultiplier = p;
+    pushValue(SimCommand::Type::SetPressureMultiplier, p);
+}
+
+void SimulationThread::setNearPressureMultiplier(Real p) {
+    settings.nearPressureMultiplier = p;
+    pushValue(SimCommand::Type::SetNearPressureMultiplier, p);
+}
+
+void SimulationThread::setViscosityStrength(Real v) {
+    settings.viscosityStrength = v;
+    pushValue(SimCommand::Type::SetViscosityStrength, v);
+}
+
+void SimulationThread::setMaxVelocity(Real v) {
+    settings.maxVelocity = v;
+    pushValue(SimCommand::Type::SetMaxVelocity, v);
+}
+
+void SimulationThread::setTimeStep(Real dt) {
+    settings.timeStep = dt;
+    pushValue(SimCommand::Type::SetTimeStep, dt);
+}
+
+void SimulationThread::setAdaptiveTimeStep(bool enabled) {
+    settings.adaptiveTimeStep = enabled;
+    pushFlag(SimCommand::Type::SetAdaptiveTimeStep, enabled ? 1 : 0);
+}
+
+void SimulationThread::setTimeStepBounds(Real minDt, Real maxDt) {
+    settings.minTimeStep = minDt;
+    settings.maxTimeStep = maxDt;
+    SimCommand command{SimCommand::Type::SetTimeStepBounds};
+    command.a = minDt;
+    command.b = maxDt;
+    push(command);
+}
+
+void SimulationThread::setCflNumber(Real c) {
+    settings.cflNumber = c;
+    pushValue(SimCommand::Type::SetCflNumber, c);
+}
+
+void SimulationThread::setForceNumber(Real f) {
+    settings.forceNumber = f;
+    pushValue(SimCommand::Type::SetForceNumber, f);
+}
+
+void SimulationThread::setDamping(Real d) {
+    settings.damping = d;
+    pushValue(SimCommand::Type::SetDamping, d);
+}
+
+void SimulationThread::setCollisionDamping(Real d) {
+    settings.collisionDamping = d;
+    pushValue(SimCommand::Type::SetCollisionDamping, d);
+}
+
+void SimulationThread::setRestDensity(Real rho) {
+    settings.restDensity = rho;
+    pushValue(SimCommand::Type::SetRestDensity, rho);
+}
+
+void SimulationThread::setUseNeighborLists(bool enabled) {
+    settings.useNeighborLists = enabled;
+    pushFlag(SimCommand::Type::SetUseNeighborLists, enabled ? 1 : 0);
+}
+
+void SimulationThread::setNeighborSkin(Real skin) {
+    settings.neighborSkin = skin;
+    pushValue(SimCommand::Type::SetNeighborSkin, skin);
+}
+
+void SimulationThread::setUseSymmetricForces(bool enabled) {
+    settings.useSymmetricForces = enabled;
+    pushFlag(SimCommand::Type::SetUseSymmetricForces, enabled ? 1 : 0);
+}
+
+void SimulationThread::setReorderInterval(int k) {
+    settings.reorderInterval = k;
+    pushFlag(SimCommand::Type::SetReorderInterval, k);
+}
+
+void SimulationThread::setKernelBackend(SimdKernels::Backend backend) {
+    settings.kernelBackend = SimdKernels::resolveBackend(backend);
+    pushFlag(SimCommand::Type::SetKernelBackend, static_cast<int>(backend));
+}
+
+void SimulationThread::setThreadCount(int threads) {
+    settings.threadCount = threads;
+    pushFlag(SimCommand::Type::SetThreadCount, threads);
+}
+
+void SimulationThread::setDeterministic(bool enabled) {
+    settings.deterministic = enabled;
+    pushFlag(SimCommand::Type::SetDeterministic, enabled ? 1 : 0);
+}
+
+void SimulationThread::setSolverMode(SolverMode mode) {
+    settings.solverMode = mode;
+    pushFlag(SimCommand::Type::SetSolverMode, static_cast<int>(mode));
+}
+
+void SimulationThread::setImplicitRestDensity(Real rho) {
+    settings.implicitRestDensity = rho;
+    pushValue(SimCommand::Type::SetImplicitRestDensity, rho);
+}
+
+void SimulationThread::setImplicitMaxIterations(int n) {
+    settings.implicitMaxIterations = n;
+    pushFlag(SimCommand::Type::SetImplicitMaxIterations, n);
+}
+
+void SimulationThread::setImplicitTolerance(Real t) {
+    settings.implicitTolerance = t;
+    pushValue(SimCommand::Type::SetImplicitTolerance, t);
+}
+
+void SimulationThread::setPositionIterations(int n) {
+    settings.positionIterations = n;
+    pushFlag(SimCommand::Type::SetPositionIterations, n);
+}
@@ -0,0 +1,212 @@
+#pragma once
+#include "FluidSimulation.h"
+#include "SimSnapshot.h"
+#include "SpscQueue.h"
+#include "TripleBuffer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+// One request from the UI / input thread to the simulation thread. Plain data so it
+// can sit in the lock-free queue; the fields used depend on the type.
+struct SimCommand {
+    enum class Type : uint8_t {
+        SetGravity,                // a, b
+        SetSmoothingRadius,        // a
+        SetPressureMultiplier,     // a
+        SetNearPressureMultiplier, // a
+        SetViscosityStrength,      // a
+        SetMaxVelocity,            // a
+        SetTimeStep,               // a
+        SetAdaptiveTimeStep,       // i
+        SetTimeStepBounds,         // a = min, b = max
+        SetCflNumber,              // a
+        SetForceNumber,            // a
+        SetDamping,                // a
+        SetCollisionDamping,       // a
+        SetRestDensity,            // a
+        SetUseNeighborLists,       // i
+        SetNeighborSkin,           // a
+        SetUseSymmetricForces,     // i
+        SetReorderInterval,        // i
+        SetKernelBackend,          // i
+        SetThreadCount,            // i
+        SetDeterministic,          // i
+        SetSolverMode,             // i
+        SetImplicitRestDensity,    // a
+        SetImplicitMaxIterations,  // i
+        SetImplicitTolerance,      // a
+        SetPositionIterations,     // i
+        SetInteraction,            // i = active, a, b = point, c = strength, d = radius
+        ResetParticles             // i = count, a, b = spread, c, d = origin
+    };
+    Type type;
+    int i = 0;
+    double a = 0, b = 0, c = 0, d = 0;
+};
+
+// Runs a FluidSimulation on its own thread. The sim thread advances on a wall-clock
+// accumulator and publishes a snapshot after every batch of steps into a triple buffer;
+// the render thread picks up the newest one without locking. Every change the UI or
+// mouse makes travels the other way as a SimCommand through a lock-free queue, applied
+// between batches.
+//
+// Pacing: in real-time mode one step of dt covers dt / timeScale seconds of wall time
+// (dt varies under adaptive stepping), so simulated time keeps pace with the clock
+// however fast frames are drawn; otherwise steps are paced at stepsPerSecond (0 = as fast as possible). Each batch runs
+// as many steps as the accumulated wall time calls for, at most maxSubsteps; time the
+// cap leaves over is dropped instead of carried, so a sim that cannot keep up slows down
+// rather than falling ever further behind. The renderer interpolates between the last
+// two states (interpolationAlpha) so motion stays smooth at any steps-per-frame ratio.
+//
+// The getters and setters mirror FluidSimulation's so UI code reads the same. Getters
+// return the UI's copy of the settings: it changes immediately on a set, and is
+// replaced by the simulation's values (after clamping) once every queued command has
+// been applied. The simulation must not be touched directly while the thread runs.
+class SimulationThread {
+public:
+    using Real = SimReal;
+    using Vec = Vec2T<Real>;
+
+private:
+    FluidSimulation& sim;
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::atomic<bool> realTime{true};
+    std::atomic<double> timeScale{1.0};      // Simulated seconds per wall second (real-time mode)
+    std::atomic<int> stepsPerSecond{60};     // Fixed-rate mode; 0 = step as fast as possible
+    std::atomic<int> maxSubsteps{8};         // Steps per batch before time is dropped
+    std::chrono::steady_clock::time_point epoch;   // Zero of the snapshot clock
+
+    SpscQueue<SimCommand, 1024> commands;
+    TripleBuffer<SimSnapshot> snapshots;
+
+    // Sim thread state
+    uint64_t stepCount = 0;
+    uint64_t commandsApplied = 0;
+    double droppedTime = 0;
+    bool interactActive = false;
+    Vec interactPoint;
+    Real interactStrength = 0;
+    Real interactRadius = 0;
+
+    // UI thread state
+    uint64_t commandsPushed = 0;
+    SimSettings settings;
+    bool lastInteractActive = false;
+    SimCommand lastInteraction{SimCommand::Type::SetInteraction};
+
+    void run();
+    void step();
+    void applyCommands();
+    void applyCommand(const SimCommand& command);
+    void publishSnapshot(double stateTime, double stepWallTime, int substeps);
+    double stepWallTime() const;
+    double now() const;
+    void push(const SimCommand& command);
+    void pushValue(SimCommand::Type type, double value);
+    void pushFlag(SimCommand::Type type, int value);
+
+public:
+    explicit SimulationThread(FluidSimulation& sim);
+    ~SimulationThread();
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    // start() publishes the current state before the thread begins stepping, so a
+    // snapshot is always available; stop() finishes the current step and joins
+    void start();
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_relaxed); }
+
+    // Pacing controls; safe to change from the UI thread while running
+    bool getRealTime() const { return realTime.load(std::memory_order_relaxed); }
+    void setRealTime(bool enabled) { realTime.store(enabled, std::memory_order_relaxed); }
+    double getTimeScale() const { return timeScale.load(std::memory_order_relaxed); }
+    void setTimeScale(double scale) { timeScale.store(std::max(1e-3, scale), std::memory_order_relaxed); }
+    int getStepsPerSecond() const { return stepsPerSecond.load(std::memory_order_relaxed); }
+    void setStepsPerSecond(int rate) { stepsPerSecond.store(std::max(0, rate), std::memory_order_relaxed); }
+    int getMaxSubsteps() const { return maxSubsteps.load(std::memory_order_relaxed); }
+    void setMaxSubsteps(int steps) { maxSubsteps.store(std::max(1, steps), std::memory_order_relaxed); }
+
+    // Render thread: swaps in the newest published snapshot (if any) and returns it.
+    // The reference stays valid and unchanged until the next acquireSnapshot().
+    const SimSnapshot& acquireSnapshot();
+    const SimSnapshot& getSnapshot() const { return snapshots.readBuffer(); }
+    // Blend factor for snapshot.interpolatedView() at the current time: rendering runs
+    // one step behind the newest state and walks from the previous state towards it
+    double interpolationAlpha(const SimSnapshot& snapshot) const;
+
+    // Mouse interaction, re-applied before every step while active
+    void setInteraction(bool active, const Vec2& point, float strength, float radius);
+    void resetParticles(int count, float spreadX, float spreadY, float originX, float originY);
+
+    // Settings (see the class comment for when the getters reflect the simulation)
+    const SimSettings& getSettings() const { return settings; }
+    const Vec& getGravity() const { return settings.gravity; }
+    void setGravity(const Vec& g);
+    Real getSmoothingRadius() const { return settings.smoothingRadius; }
+    void setSmoothingRadius(Real h);
+    Real getPressureMultiplier() const { return settings.pressureMultiplier; }
+    void setPressureMultiplier(Real p);
+    Real getNearPressureMultiplier() const { return settings.nearPressureMultiplier; }
+    void setNearPressureMultiplier(Real p);
+    Real getViscosityStrength() const { return settings.viscosityStrength; }
+    void setViscosityStrength(Real v);
+    Real getMaxVelocity() const { return settings.maxVelocity; }
+    void setMaxVelocity(Real v);
+    Real getTimeStep() const { return settings.timeStep; }
+    void setTimeStep(Real dt);
+    bool getAdaptiveTimeStep() const { return settings.adaptiveTimeStep; }
+    void setAdaptiveTimeStep(bool enabled);
+    Real getMinTimeStep() const { return settings.minTimeStep; }
+    Real getMaxTimeStep() const { return settings.maxTimeStep; }
+    void setTimeStepBounds(Real minDt, Real maxDt);
+    Real getCflNumber() const { return settings.cflNumber; }
+    void setCflNumber(Real c);
+    Real getForceNumber() const { return settings.forceNumber; }
+    void setForceNumber(Real f);
+    Real getDamping() const { return settings.damping; }
+    void setDamping(Real d);
+    Real getCollisionDamping() const { return settings.collisionDamping; }
+    void setCollisionDamping(Real d);
+    Real getRestDensity() const { return settings.restDensity; }
+    void setRestDensity(Real rho);
+    bool getUseNeighborLists() const { return settings.useNeighborLists; }
+    void setUseNeighborLists(bool enabled);
+    Real getNeighborSkin() const { return settings.neighborSkin; }
+    void setNeighborSkin(Real skin);
+    bool getUseSymmetricForces() const { return settings.useSymmetricForces; }
+    void setUseSymmetricForces(bool enabled);
+    int getReorderInterval() const { return settings.reorderInterval; }
+    void setReorderInterval(int k);
+    SimdKernels::Backend getKernelBackend() const { return settings.kernelBackend; }
+    void setKernelBackend(SimdKernels::Backend backend);
+    int getThreadCount() const { return settings.threadCount; }
+    void setThreadCount(int threads);
+    bool getDeterministic() const { return settings.deterministic; }
+    void setDeterministic(bool enabled);
+    SolverMode getSolverMode() const { return settings.solverMode; }
+    void setSolverMode(SolverMode mode);
+    Real getImplicitRestDensity() const { return settings.implicitRestDensity; }
+    void setImplicitRestDensity(Real rho);
+    int getImplicitMaxIterations() const { return settings.implicitMaxIterations; }
+    void setImplicitMaxIterations(int n);
+    Real getImplicitTolerance() const { return settings.implicitTolerance; }
+    void setImplicitTolerance(Real t);
+    int getPositionIterations() const { return settings.positionIterations; }
+    void setPositionIterations(int n);
+
+    // Statistics from the current snapshot
+    uint64_t getStepCount() const { return getSnapshot().step; }
+    int getLastSubsteps() const { return getSnapshot().substeps; }
+    double getDroppedTime() const { return getSnapshot().droppedTime; }
+    Real getLastTimeStep() const { return getSnapshot().lastTimeStep; }
+    uint64_t getNeighborListRebuilds() const { return getSnapshot().neighborListRebuilds; }
+    uint64_t getNeighborListSteps() const { return getSnapshot().neighborListSteps; }
+    double getNeighborListRebuildRate() const { return getSnapshot().getNeighborListRebuildRate(); }
+    int getImplicitIterations() const { return getSnapshot().implicitIterations; }
+    Real getImplicitDensityError() const { return getSnapshot().implicitDensityError; }
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+// Pressure solver used by BasicFluidSimulation::update()
+enum class SolverMode {
+    Explicit = 0,   // Equation of state (pressureOf) with explicit pressure forces
+    IISPH = 1,      // Implicit incompressible SPH: pressures solved by relaxed Jacobi iterations
+    PBF = 2         // Position Based Fluids: density constraints solved on predicted positions
+};
+
+inline const char* solverModeName(SolverMode mode) {
+    switch (mode) {
+        case SolverMode::Explicit: return "Explicit";
+        case SolverMode::IISPH: return "IISPH";
+        case SolverMode::PBF: return "PBF";
+    }
+    return "Unknown";
+}
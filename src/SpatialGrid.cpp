@@ -0,0 +1,124 @@
+#include "SpatialGrid.h"
+#include "ThreadPool.h"
+#include <cmath>
+#include <utility>
+
+namespace {
+// Upper bound on cells per axis so tiny smoothing radii cannot blow up the cell table
+constexpr int kMaxCellsPerAxis = 1024;
+// Below this many particles a parallel build costs more in wakeups than it saves
+constexpr size_t kParallelMinParticles = 4096;
+// Cap on the per-chunk histogram table (chunks * cells entries)
+constexpr size_t kMaxChunkTable = size_t(1) << 22;
+}
+
+template <typename Real>
+void SpatialGrid::build(const Real* xs, const Real* ys, size_t n, double minCellSize,
+                        double minX, double minY, double maxX, double maxY, ThreadPool* pool) {
+    const double extentX = std::max(maxX - minX, 1e-6);
+    const double extentY = std::max(maxY - minY, 1e-6);
+    cellSize = std::max({ minCellSize, extentX / kMaxCellsPerAxis, extentY / kMaxCellsPerAxis });
+    invCellSize = 1.0 / cellSize;
+    originX = minX;
+    originY = minY;
+    const int prevW = gridW;
+    const int prevH = gridH;
+    gridW = std::max(1, static_cast<int>(std::ceil(extentX * invCellSize)));
+    gridH = std::max(1, static_cast<int>(std::ceil(extentY * invCellSize)));
+    if (gridW != prevW || gridH != prevH) {
+        rebuildMortonOrder();
+    }
+
+    const size_t cells = getCellCount();
+    // assign/resize keep capacity, so steady-state rebuilds do not touch the heap
+    particleCell.resize(n);
+    sortedIndices.resize(n);
+    cellStart.assign(cells + 1, 0);
+
+    const size_t chunks = pool ? static_cast<size_t>(pool->getThreadCount()) : 1;
+    if (chunks > 1 && n >= kParallelMinParticles && chunks * cells <= kMaxChunkTable) {
+        // Each chunk is a fixed particle range with its own histogram. Offsets are laid
+        // out cell-major, chunk-minor, so the scatter stays stable across chunks.
+        const size_t chunkSize = (n + chunks - 1) / chunks;
+        chunkCounts.assign(chunks * cells, 0);
+        pool->run(chunks, [&](size_t c) {
+            uint32_t* counts = chunkCounts.data() + c * cells;
+            const size_t end = std::min(n, (c + 1) * chunkSize);
+            for (size_t i = c * chunkSize; i < end; ++i) {
+                const uint32_t key = static_cast<uint32_t>(cellY(ys[i])) * gridW
+                                   + static_cast<uint32_t>(cellX(xs[i]));
+                particleCell[i] = key;
+                ++counts[key];
+            }
+        });
+        uint32_t running = 0;
+        for (size_t cell = 0; cell < cells; ++cell) {
+            cellStart[cell] = running;
+            for (size_t c = 0; c < chunks; ++c) {
+                uint32_t& slot = chunkCounts[c * cells + cell];
+                const uint32_t count = slot;
+                slot = running;
+                running += count;
+            }
+        }
+        cellStart[cells] = running;
+        pool->run(chunks, [&](size_t c) {
+            uint32_t* cursor = chunkCounts.data() + c * cells;
+            const size_t end = std::min(n, (c + 1) * chunkSize);
+            for (size_t i = c * chunkSize; i < end; ++i) {
+                sortedIndices[cursor[particleCell[i]]++] = static_cast<uint32_t>(i);
+            }
+        });
+        return;
+    }
+
+    // 1) Key every particle and histogram the keys
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t key = static_cast<uint32_t>(cellY(ys[i])) * gridW
+                           + static_cast<uint32_t>(cellX(xs[i]));
+        particleCell[i] = key;
+        ++cellStart[key + 1];
+    }
+
+    // 2) Prefix sum turns counts into start offsets
+    for (size_t c = 0; c < cells; ++c) {
+        cellStart[c + 1] += cellStart[c];
+    }
+
+    // 3) Stable scatter: indices stay ascending within each cell
+    cellCursor.assign(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < n; ++i) {
+        sortedIndices[cellCursor[particleCell[i]]++] = static_cast<uint32_t>(i);
+    }
+}
+
+template void SpatialGrid::build<float>(const float*, const float*, size_t, double, double, double, double, double, ThreadPool*);
+template void SpatialGrid::build<double>(const double*, const double*, size_t, double, double, double, double, double, ThreadPool*);
+
+uint32_t SpatialGrid::mortonCode(uint32_t x, uint32_t y) {
+    auto spread = [](uint32_t v) {
+        v &= 0x0000FFFFu;
+        v = (v | (v << 8)) & 0x00FF00FFu;
+        v = (v | (v << 4)) & 0x0F0F0F0Fu;
+        v = (v | (v << 2)) & 0x33333333u;
+        v = (v | (v << 1)) & 0x55555555u;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1);
+}
+
+void SpatialGrid::rebuildMortonOrder() {
+    std::vector<std::pair<uint32_t, uint32_t>> coded;
+    coded.reserve(getCellCount());
+    for (int cy = 0; cy < gridH; ++cy) {
+        for (int cx = 0; cx < gridW; ++cx) {
+            const uint32_t key = static_cast<uint32_t>(cy) * gridW + static_cast<uint32_t>(cx);
+            coded.emplace_back(mortonCode(static_cast<uint32_t>(cx), static_cast<uint32_t>(cy)), key);
+        }
+    }
+    std::sort(coded.begin(), coded.end());
+    mortonOrder.resize(coded.size());
+    for (size_t i = 0; i < coded.size(); ++i) {
+        mortonOrder[i] = coded[i].second;
+    }
+}
@@ -0,0 +1,174 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+class ThreadPool;
+
+// Dense uniform grid over the bounded simulation domain used for neighbor search.
+// Particle indices are counting-sorted by cell key into one contiguous array with a
+// cell-start table alongside, so a rebuild is allocation-free once the buffers have
+// grown and a stencil walk reads memory linearly.
+class SpatialGrid {
+private:
+    double originX = 0.0;
+    double originY = 0.0;
+    double cellSize = 0.1;
+    double invCellSize = 10.0;
+    int gridW = 0;
+    int gridH = 0;
+
+    std::vector<uint32_t> particleCell;   // Cell key of each particle (cy * gridW + cx)
+    std::vector<uint32_t> cellStart;      // Offset of each cell in sortedIndices (cells + 1 entries)
+    std::vector<uint32_t> cellCursor;     // Scatter cursor reused by the counting sort
+    std::vector<uint32_t> sortedIndices;  // Particle indices grouped by cell key
+    std::vector<uint32_t> mortonOrder;    // Cell keys in Z-order, rebuilt only when the dimensions change
+    std::vector<uint32_t> chunkCounts;    // Per-chunk histograms / cursors of a parallel build
+
+    void rebuildMortonOrder();
+
+public:
+    // Rebins all particles. Cells are at least `minCellSize` wide so a 3x3 stencil
+    // covers the kernel support; positions outside the bounds clamp to edge cells.
+    // With a pool, keying, counting and scattering run in per-thread chunks; the result
+    // is identical to the serial build. Instantiated for float and double positions.
+    template <typename Real>
+    void build(const Real* xs, const Real* ys, size_t n, double minCellSize,
+               double minX, double minY, double maxX, double maxY, ThreadPool* pool = nullptr);
+
+    int cellX(double x) const {
+        int cx = static_cast<int>((x - originX) * invCellSize);
+        return std::max(0, std::min(gridW - 1, cx));
+    }
+    int cellY(double y) const {
+        int cy = static_cast<int>((y - originY) * invCellSize);
+        return std::max(0, std::min(gridH - 1, cy));
+    }
+
+    int getWidth() const { return gridW; }
+    int getHeight() const { return gridH; }
+    double getCellSize() const { return cellSize; }
+    size_t getCellCount() const { return static_cast<size_t>(gridW) * gridH; }
+    size_t getParticleCount() const { return particleCell.size(); }  // Particles binned by the last build
+    uint32_t cellBegin(size_t key) const { return cellStart[key]; }
+    uint32_t cellEnd(size_t key) const { return cellStart[key + 1]; }
+    uint32_t getParticleCell(size_t i) const { return particleCell[i]; }
+    const uint32_t* getSortedIndices() const { return sortedIndices.data(); }
+    const std::vector<uint32_t>& getMortonCellOrder() const { return mortonOrder; }
+
+    // Interleaves the low 16 bits of x and y into a Z-order (Morton) code
+    static uint32_t mortonCode(uint32_t x, uint32_t y);
+
+    // Visits every particle index binned in the 3x3 cell stencil around (x, y).
+    // Cells of one stencil row are adjacent keys, so each row is a single span.
+    template <typename Fn>
+    void forEachCandidate(double x, double y, Fn&& fn) const {
+        if (gridW == 0) return;
+        const int cx = cellX(x);
+        const int cy = cellY(y);
+        const int x0 = std::max(cx - 1, 0);
+        const int x1 = std::min(cx + 1, gridW - 1);
+        const int y0 = std::max(cy - 1, 0);
+        const int y1 = std::min(cy + 1, gridH - 1);
+        for (int row = y0; row <= y1; ++row) {
+            const size_t rowKey = static_cast<size_t>(row) * gridW;
+            const uint32_t end = cellStart[rowKey + x1 + 1];
+            for (uint32_t k = cellStart[rowKey + x0]; k < end; ++k) {
+                fn(sortedIndices[k]);
+            }
+        }
+    }
+
+    // Same stencil as forEachCandidate, but hands each row to fn(indices, count) as one
+    // contiguous run of getSortedIndices(), so batched kernels can consume it directly.
+    template <typename Fn>
+    void forEachCandidateSpan(double x, double y, Fn&& fn) const {
+        if (gridW == 0) return;
+        const int cx = cellX(x);
+        const int cy = cellY(y);
+        const int x0 = std::max(cx - 1, 0);
+        const int x1 = std::min(cx + 1, gridW - 1);
+        const int y0 = std::max(cy - 1, 0);
+        const int y1 = std::min(cy + 1, gridH - 1);
+        for (int row = y0; row <= y1; ++row) {
+            const size_t rowKey = static_cast<size_t>(row) * gridW;
+            const uint32_t begin = cellStart[rowKey + x0];
+            const uint32_t end = cellStart[rowKey + x1 + 1];
+            if (end > begin) fn(sortedIndices.data() + begin, static_cast<size_t>(end - begin));
+        }
+    }
+
+    // Row spans of every cell overlapping the box [minX, maxX] x [minY, maxY], for queries
+    // whose reach is not exactly one cell (box corners outside the grid clamp to edge cells)
+    template <typename Fn>
+    void forEachCandidateSpanInBox(double minX, double minY, double maxX, double maxY, Fn&& fn) const {
+        if (gridW == 0) return;
+        const int x0 = cellX(minX);
+        const int x1 = cellX(maxX);
+        const int y0 = cellY(minY);
+        const int y1 = cellY(maxY);
+        for (int row = y0; row <= y1; ++row) {
+            const size_t rowKey = static_cast<size_t>(row) * gridW;
+            const uint32_t begin = cellStart[rowKey + x0];
+            const uint32_t end = cellStart[rowKey + x1 + 1];
+            if (end > begin) fn(sortedIndices.data() + begin, static_cast<size_t>(end - begin));
+        }
+    }
+
+    // Largest distance from particles [begin, end) at (xs, ys) to the cells they were
+    // binned in by the last build, i.e. how far they have moved out of their cells since
+    template <typename Real>
+    double maxDrift(const Real* xs, const Real* ys, size_t begin, size_t end) const {
+        double drift = 0.0;
+        for (size_t i = begin; i < end; ++i) {
+            const uint32_t key = particleCell[i];
+            const double left = originX + static_cast<double>(key % gridW) * cellSize;
+            const double bottom = originY + static_cast<double>(key / gridW) * cellSize;
+            const double x = static_cast<double>(xs[i]);
+            const double y = static_cast<double>(ys[i]);
+            drift = std::max(drift, std::max(left - x, x - (left + cellSize)));
+            drift = std::max(drift, std::max(bottom - y, y - (bottom + cellSize)));
+        }
+        return drift;
+    }
+
+    // Visits every unordered candidate pair (i, j) exactly once using a half stencil:
+    // pairs inside a cell, then each cell against its east neighbor and the three
+    // cells of the row above (one contiguous span).
+    template <typename Fn>
+    void forEachCandidatePair(Fn&& fn) const {
+        for (int cy = 0; cy < gridH; ++cy) {
+            for (int cx = 0; cx < gridW; ++cx) {
+                const size_t key = static_cast<size_t>(cy) * gridW + cx;
+                const uint32_t begin = cellStart[key];
+                const uint32_t end = cellStart[key + 1];
+                if (begin == end) continue;
+
+                for (uint32_t a = begin; a < end; ++a) {
+                    for (uint32_t b = a + 1; b < end; ++b) {
+                        fn(sortedIndices[a], sortedIndices[b]);
+                    }
+                }
+
+                const uint32_t eastEnd = cx + 1 < gridW ? cellStart[key + 2] : end;
+                uint32_t northBegin = 0;
+                uint32_t northEnd = 0;
+                if (cy + 1 < gridH) {
+                    const size_t northKey = key + gridW;
+                    northBegin = cellStart[northKey - (cx > 0 ? 1 : 0)];
+                    northEnd = cellStart[northKey + (cx + 1 < gridW ? 2 : 1)];
+                }
+                for (uint32_t a = begin; a < end; ++a) {
+                    const uint32_t i = sortedIndices[a];
+                    for (uint32_t b = end; b < eastEnd; ++b) {
+                        fn(i, sortedIndices[b]);
+                    }
+                    for (uint32_t b = northBegin; b < northEnd; ++b) {
+                        fn(i, sortedIndices[b]);
+                    }
+                }
+            }
+        }
+    }
+};
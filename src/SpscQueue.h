@@ -0,0 +1,34 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free single-producer / single-consumer ring buffer. push() and pop()
+// each touch only their own index plus one acquire load of the other side's.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+private:
+    T slots[Capacity];
+    alignas(64) std::atomic<size_t> head{0};   // Next slot to pop (consumer)
+    alignas(64) std::atomic<size_t> tail{0};   // Next slot to push (producer)
+
+public:
+    // Producer side; false when the queue is full
+    bool push(const T& value) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Capacity) return false;
+        slots[t & (Capacity - 1)] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; false when the queue is empty
+    bool pop(T& out) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        out = slots[h & (Capacity - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
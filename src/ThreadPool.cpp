@@ -0,0 +1,147 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int threads) {
+    startWorkers(std::max(1, threads) - 1);
+}
+
+ThreadPool::~ThreadPool() {
+    stopWorkers();
+}
+
+int ThreadPool::hardwareThreads() {
+    const unsigned n = std::thread::hardware_concurrency();
+    return n > 0 ? static_cast<int>(n) : 1;
+}
+
+void ThreadPool::setThreadCount(int threads) {
+    threads = std::max(1, threads);
+    if (threads == getThreadCount()) return;
+    stopWorkers();
+    startWorkers(threads - 1);
+}
+
+void ThreadPool::startWorkers(int count) {
+    stopping = false;
+    deques.reset(new TaskDeque[count + 1]);
+    workers.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const uint64_t current = generation;
+        workers.emplace_back([this, i, current] { workerLoop(i + 1, current); });
+    }
+}
+
+void ThreadPool::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : workers) t.join();
+    workers.clear();
+}
+
+// Contiguous blocks keep neighboring tasks (e.g. Morton-adjacent cell groups) on one thread
+void ThreadPool::dealTasks(size_t tasks, const uint32_t* weights) {
+    const size_t threads = static_cast<size_t>(getThreadCount());
+    if (!weights) {
+        for (size_t t = 0; t < threads; ++t) {
+            deques[t].head = tasks * t / threads;
+            deques[t].tail = tasks * (t + 1) / threads;
+        }
+        return;
+    }
+    uint64_t total = 0;
+    for (size_t k = 0; k < tasks; ++k) total += weights[k];
+    size_t k = 0;
+    uint64_t running = 0;
+    for (size_t t = 0; t < threads; ++t) {
+        deques[t].head = k;
+        const uint64_t limit = total * (t + 1) / threads;
+        while (k < tasks && (t + 1 == threads || running + weights[k] / 2 < limit)) {
+            running += weights[k++];
+        }
+        deques[t].tail = k;
+    }
+}
+
+bool ThreadPool::popTask(int self, size_t& task) {
+    TaskDeque& own = deques[self];
+    std::lock_guard<std::mutex> lock(own.lock);
+    if (own.head >= own.tail) return false;
+    task = own.head++;
+    return true;
+}
+
+// Moves the back half of the fullest other deque into this (empty) deque
+bool ThreadPool::stealTasks(int self) {
+    const int threads = getThreadCount();
+    for (;;) {
+        int victim = -1;
+        size_t most = 0;
+        for (int k = 1; k < threads; ++k) {
+            const int v = (self + k) % threads;
+            std::lock_guard<std::mutex> lock(deques[v].lock);
+            const size_t left = deques[v].tail > deques[v].head ? deques[v].tail - deques[v].head : 0;
+            if (left > most) {
+                most = left;
+                victim = v;
+            }
+        }
+        if (victim < 0) return false;
+
+        size_t begin, end;
+        {
+            std::lock_guard<std::mutex> lock(deques[victim].lock);
+            const size_t left = deques[victim].tail > deques[victim].head
+                              ? deques[victim].tail - deques[victim].head : 0;
+            if (left == 0) continue;  // Drained meanwhile; look again
+            end = deques[victim].tail;
+            begin = end - (left + 1) / 2;
+            deques[victim].tail = begin;
+        }
+        std::lock_guard<std::mutex> lock(deques[self].lock);
+        deques[self].head = begin;
+        deques[self].tail = end;
+        return true;
+    }
+}
+
+void ThreadPool::drainTasks(int self) {
+    size_t task;
+    do {
+        while (popTask(self, task)) jobCall(jobContext, task);
+    } while (stealTasks(self));
+}
+
+void ThreadPool::runJob(size_t tasks, const uint32_t* weights, void (*call)(void*, size_t), void* context) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobCall = call;
+        jobContext = context;
+        dealTasks(tasks, weights);
+        busyWorkers = static_cast<int>(workers.size());
+        ++generation;
+    }
+    wake.notify_all();
+    drainTasks(0);
+    // Barrier: the job (and the caller's stack frame it points into) must outlive every worker's use
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return busyWorkers == 0; });
+}
+
+void ThreadPool::workerLoop(int self, uint64_t seen) {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        drainTasks(self);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busyWorkers == 0) finished.notify_one();
+        }
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Persistent fork-join worker pool. The calling thread takes part in every job, so a
+// pool of N threads owns N - 1 workers; with one thread everything runs inline. Each
+// run() returns only after all tasks finished, which is the barrier between phases.
+//
+// Scheduling is work-stealing: every thread owns a deque of task indices, dealt out in
+// contiguous blocks (balanced by weight when the caller supplies weights). A thread
+// pops from the front of its own deque and, once empty, steals the back half of the
+// fullest other deque, so uneven tasks rebalance without a shared counter.
+class ThreadPool {
+private:
+    // One thread's deque: the task index range [head, tail)
+    struct alignas(64) TaskDeque {
+        std::mutex lock;
+        size_t head = 0;
+        size_t tail = 0;
+    };
+
+    std::vector<std::thread> workers;
+    std::unique_ptr<TaskDeque[]> deques;  // One per thread; deques[0] belongs to the caller
+    std::mutex mutex;
+    std::condition_variable wake;        // Workers wait here for a new job
+    std::condition_variable finished;    // run() waits here for the workers to drain
+    bool stopping = false;
+    uint64_t generation = 0;             // Bumped per job so workers see each one once
+
+    // Current job, type-erased so run() stays a template without std::function
+    void (*jobCall)(void*, size_t) = nullptr;
+    void* jobContext = nullptr;
+    int busyWorkers = 0;
+
+    // Block results of reduce(), kept across calls so a reduction does not allocate
+    // once the buffer has grown to the largest block count seen
+    std::vector<std::max_align_t> reduceScratch;
+
+    void workerLoop(int self, uint64_t seen);
+    void drainTasks(int self);
+    bool popTask(int self, size_t& task);
+    bool stealTasks(int self);
+    void dealTasks(size_t tasks, const uint32_t* weights);
+    void runJob(size_t tasks, const uint32_t* weights, void (*call)(void*, size_t), void* context);
+    void startWorkers(int count);
+    void stopWorkers();
+
+public:
+    explicit ThreadPool(int threads = 1);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Total threads used by run(), including the caller (clamped to at least 1)
+    int getThreadCount() const { return static_cast<int>(workers.size()) + 1; }
+    void setThreadCount(int threads);
+    static int hardwareThreads();
+
+    // Calls fn(task) for every task in [0, tasks), spread over the pool; blocks until done.
+    // With weights (one per task, e.g. particle pairs in a cell group) the initial deal
+    // gives every thread about the same total weight.
+    template <typename Fn>
+    void run(size_t tasks, Fn&& fn, const uint32_t* weights = nullptr) {
+        if (tasks == 0) return;
+        if (workers.empty() || tasks == 1) {
+            for (size_t t = 0; t < tasks; ++t) fn(t);
+            return;
+        }
+        using F = typename std::remove_reference<Fn>::type;
+        runJob(tasks, weights, [](void* ctx, size_t t) { (*static_cast<F*>(ctx))(t); }, &fn);
+    }
+
+    // Splits [0, count) into chunks of at least `grain` items (about four per thread for
+    // balance) and calls fn(begin, end) for each; blocks until every chunk is done
+    template <typename Fn>
+    void parallelFor(size_t count, size_t grain, Fn&& fn) {
+        if (count == 0) return;
+        const size_t threads = static_cast<size_t>(getThreadCount());
+        const size_t target = threads > 1 ? threads * 4 : 1;
+        size_t chunk = (count + target - 1) / target;
+        if (chunk < grain) chunk = grain;
+        const size_t chunks = (count + chunk - 1) / chunk;
+        run(chunks, [&](size_t c) {
+            const size_t begin = c * chunk;
+            const size_t end = begin + chunk < count ? begin + chunk : count;
+            fn(begin, end);
+        });
+    }
+
+    // Deterministic reduction: [0, count) is cut into fixed blocks of `block` items
+    // (independent of the thread count), mapBlock(begin, end) reduces each block
+    // serially, and the block results are combined pairwise in a fixed binary tree,
+    // so floating-point results are bitwise identical for any number of threads.
+    // T must be trivially copyable; the block results live in a per-pool scratch buffer,
+    // so reduce() must not be called from inside another job of the same pool.
+    template <typename T, typename MapFn, typename CombineFn>
+    T reduce(size_t count, size_t block, T identity, MapFn&& mapBlock, CombineFn&& combine) {
+        if (count == 0) return identity;
+        if (block == 0) block = 1;
+        static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value,
+                      "reduce() keeps block results in raw scratch storage");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned reduction type");
+        const size_t blocks = (count + block - 1) / block;
+        const size_t words = (blocks * sizeof(T) + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+        if (reduceScratch.size() < words) reduceScratch.resize(words);
+        T* partial = reinterpret_cast<T*>(reduceScratch.data());
+        run(blocks, [&](size_t b) {
+            const size_t end = (b + 1) * block < count ? (b + 1) * block : count;
+            new (&partial[b]) T(mapBlock(b * block, end));
+        });
+        for (size_t stride = 1; stride < blocks; stride *= 2) {
+            for (size_t b = 0; b + stride < blocks; b += 2 * stride) {
+                partial[b] = combine(partial[b], partial[b + stride]);
+            }
+        }
+        return partial[0];
+    }
+};
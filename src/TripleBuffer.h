@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single-producer / single-consumer triple buffer. The writer fills
+// writeBuffer() and publish()es it; the reader acquire()s the newest published
+// buffer and keeps reading it until the next acquire. Neither side ever waits, and
+// the reader never sees a half-written value. Buffers are reused, so values that own
+// memory (vectors) stop allocating once all three have grown.
+template <typename T>
+class TripleBuffer {
+private:
+    static constexpr uint8_t kIndexMask = 0x3;
+    static constexpr uint8_t kFresh = 0x4;   // Set when the middle buffer holds an unread publish
+
+    T buffers[3];
+    uint8_t back = 0;                        // Owned by the writer
+    uint8_t front = 1;                       // Owned by the reader
+    std::atomic<uint8_t> middle{2};          // Handed back and forth, plus the fresh bit
+
+public:
+    T& writeBuffer() { return buffers[back]; }
+
+    // Makes the write buffer the newest value and takes the middle one to write next
+    void publish() {
+        const uint8_t previous = middle.exchange(static_cast<uint8_t>(back | kFresh), std::memory_order_acq_rel);
+        back = previous & kIndexMask;
+    }
+
+    // Swaps in the newest published value if there is one; returns whether it did
+    bool acquire() {
+        if (!(middle.load(std::memory_order_relaxed) & kFresh)) return false;
+        const uint8_t previous = middle.exchange(front, std::memory_order_acq_rel);
+        front = previous & kIndexMask;
+        return true;
+    }
+
+    const T& readBuffer() const { return buffers[front]; }
+};
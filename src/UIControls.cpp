@@ -1,13 +1,16 @@
 #include "UIControls.h"
-#include "FluidSimulation.h"
+#include "SimulationThread.h"
 #include "../external/imgui.h"
 #include <cmath>
+#include <algorithm>
 
-void UIControls::drawGui(FluidSimulation& sim) {
+void UIControls::drawGui(SimulationThread& sim) {
     ImGui::Begin("Simulation Controls");
+    ImGui::Text("Simulation step %llu", static_cast<unsigned long long>(sim.getStepCount()));
+    ImGui::Separator();
     ImGui::Text("Gravity");
     // sync initial value if needed
-    const Vec2& g = sim.getGravity();
+    const auto& g = sim.getGravity();
     if (std::abs(uiGravityX - static_cast<float>(g.x)) > 1e-6f) {
         uiGravityX = static_cast<float>(g.x);
     }
@@ -41,46 +44,57 @@ void UIControls::drawGui(FluidSimulation& sim) {
         ImGui::SetTooltip("Smoothing radius for SPH kernels (affects interaction range)");
     }
 
+    // Pressure, near pressure, viscosity and the explicit rest density only act in the
+    // explicit solver; IISPH and PBF ignore them, so their controls are greyed out then
+    const bool explicitSolver = sim.getSolverMode() == SolverMode::Explicit;
+    const char* explicitOnly = explicitSolver ? "" : " (explicit solver only)";
+
     ImGui::Separator();
-    ImGui::Text("Pressure Multiplier");
+    ImGui::Text("Pressure Multiplier%s", explicitOnly);
     // sync UI value with simulation
     float simPM = static_cast<float>(sim.getPressureMultiplier());
     if (std::abs(uiPressureMultiplier - simPM) > 1e-6f) {
         uiPressureMultiplier = simPM;
     }
+    ImGui::BeginDisabled(!explicitSolver);
     if (ImGui::SliderFloat("Pressure Multiplier", &uiPressureMultiplier, 0.5f, 10.0f, "%.5f")) {
         sim.setPressureMultiplier(static_cast<double>(uiPressureMultiplier));
     }
-    if (ImGui::IsItemHovered()) {
+    ImGui::EndDisabled();
+    if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) {
         ImGui::SetTooltip("Multiplier for regular pressure force");
     }
 
     ImGui::Separator();
-    ImGui::Text("Near Pressure Multiplier");
+    ImGui::Text("Near Pressure Multiplier%s", explicitOnly);
     // sync UI value with simulation
     float simNPM = static_cast<float>(sim.getNearPressureMultiplier());
     if (std::abs(uiNearPressureMultiplier - simNPM) > 1e-6f) {
         uiNearPressureMultiplier = simNPM;
     }
+    ImGui::BeginDisabled(!explicitSolver);
     if (ImGui::SliderFloat("Near Pressure Multiplier", &uiNearPressureMultiplier, 0.1f, 20.0f, "%.5f")) {
         sim.setNearPressureMultiplier(static_cast<double>(uiNearPressureMultiplier));
     }
-    if (ImGui::IsItemHovered()) {
+    ImGui::EndDisabled();
+    if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) {
         ImGui::SetTooltip("Multiplier for near pressure force (prevents particle clustering)");
     }
 
     ImGui::Separator();
-    ImGui::Text("Viscosity Strength");
+    ImGui::Text("Viscosity Strength%s", explicitOnly);
     // sync UI value with simulation
     float simVisc = static_cast<float>(sim.getViscosityStrength());
     if (std::abs(uiViscosityStrength - simVisc) > 1e-6f) {
         uiViscosityStrength = simVisc;
     }
-    if (ImGui::SliderFloat("Viscosity Strength", &uiViscosityStrength, 0.0f, 1.0f, "%.5f")) {
+    ImGui::BeginDisabled(!explicitSolver);
+    if (ImGui::SliderFloat("Viscosity Strength", &uiViscosityStrength, 0.0f, 10.0f, "%.3f")) {
         sim.setViscosityStrength(static_cast<double>(uiViscosityStrength));
     }
-    if (ImGui::IsItemHovered()) {
-        ImGui::SetTooltip("Strength of viscosity force (smooths velocity differences between particles)");
+    ImGui::EndDisabled();
+    if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) {
+        ImGui::SetTooltip("Kinematic viscosity: rate per second at which velocity differences between neighbors are smoothed out");
     }
 
     ImGui::Separator();
@@ -109,6 +123,73 @@ void UIControls::drawGui(FluidSimulation& sim) {
     if (ImGui::IsItemHovered()) {
         ImGui::SetTooltip("Simulation time step (smaller = more stable but slower)");
     }
+    uiAdaptiveTimeStep = sim.getAdaptiveTimeStep();
+    if (ImGui::Checkbox("Adaptive Time Step", &uiAdaptiveTimeStep)) {
+        sim.setAdaptiveTimeStep(uiAdaptiveTimeStep);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Pick dt every step from the fastest particle and the largest acceleration (CFL and force criteria)");
+    }
+    if (uiAdaptiveTimeStep) {
+        uiMinTimeStep = static_cast<float>(sim.getMinTimeStep());
+        uiMaxTimeStep = static_cast<float>(sim.getMaxTimeStep());
+        bool boundsChanged = ImGui::SliderFloat("Min dt", &uiMinTimeStep, 0.0001f, 0.005f, "%.5f");
+        boundsChanged |= ImGui::SliderFloat("Max dt", &uiMaxTimeStep, 0.001f, 0.05f, "%.5f");
+        if (boundsChanged) {
+            sim.setTimeStepBounds(uiMinTimeStep, std::max(uiMinTimeStep, uiMaxTimeStep));
+        }
+        uiCflNumber = static_cast<float>(sim.getCflNumber());
+        if (ImGui::SliderFloat("CFL Number", &uiCflNumber, 0.05f, 1.0f, "%.2f")) {
+            sim.setCflNumber(uiCflNumber);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Largest fraction of h the fastest particle may travel in one step");
+        }
+        uiForceNumber = static_cast<float>(sim.getForceNumber());
+        if (ImGui::SliderFloat("Force Number", &uiForceNumber, 0.05f, 1.0f, "%.2f")) {
+            sim.setForceNumber(uiForceNumber);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Scale of the acceleration limit dt <= force * sqrt(h / max|a|)");
+        }
+    }
+    ImGui::Text("Current dt: %.5f", static_cast<double>(sim.getLastTimeStep()));
+
+    ImGui::Separator();
+    ImGui::Text("Timing");
+    // sync UI values with the simulation thread
+    uiRealTime = sim.getRealTime();
+    uiTimeScale = static_cast<float>(sim.getTimeScale());
+    uiStepsPerSecond = sim.getStepsPerSecond();
+    uiMaxSubsteps = sim.getMaxSubsteps();
+    if (ImGui::Checkbox("Real Time", &uiRealTime)) {
+        sim.setRealTime(uiRealTime);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Run as many steps as needed to keep simulated time in step with the clock");
+    }
+    if (uiRealTime) {
+        if (ImGui::SliderFloat("Time Scale", &uiTimeScale, 0.05f, 2.0f, "%.2f")) {
+            sim.setTimeScale(uiTimeScale);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Simulated seconds per real second");
+        }
+    } else {
+        if (ImGui::SliderInt("Steps / Second", &uiStepsPerSecond, 0, 1000, "%d")) {
+            sim.setStepsPerSecond(uiStepsPerSecond);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Fixed step rate (0 = as fast as possible)");
+        }
+    }
+    if (ImGui::SliderInt("Max Substeps", &uiMaxSubsteps, 1, 32, "%d")) {
+        sim.setMaxSubsteps(uiMaxSubsteps);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Most steps run to catch up at once; time beyond that is dropped so a slow sim cannot spiral");
+    }
+    ImGui::Text("Last batch: %d steps, dropped %.2f s", sim.getLastSubsteps(), sim.getDroppedTime());
 
     ImGui::Separator();
     ImGui::Text("Damping");
@@ -147,19 +228,146 @@ void UIControls::drawGui(FluidSimulation& sim) {
     }
 
     ImGui::Separator();
-    ImGui::Text("Rest Density");
+    ImGui::Text("Rest Density%s", explicitOnly);
     // sync UI value with simulation
     float simRestDensity = static_cast<float>(sim.getRestDensity());
     if (std::abs(uiRestDensity - simRestDensity) > 1e-6f) {
         uiRestDensity = simRestDensity;
     }
+    ImGui::BeginDisabled(!explicitSolver);
     if (ImGui::SliderFloat("Rest Density", &uiRestDensity, 0.1f, 5.0f, "%.3f")) {
         sim.setRestDensity(static_cast<double>(uiRestDensity));
     }
-    if (ImGui::IsItemHovered()) {
+    ImGui::EndDisabled();
+    if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) {
         ImGui::SetTooltip("Target density for pressure calculation");
     }
 
+    ImGui::Separator();
+    ImGui::Text("Solver");
+    // sync UI values with simulation
+    uiSolverMode = static_cast<int>(sim.getSolverMode());
+    const char* solverItems[] = { "Explicit", "IISPH", "PBF" };
+    if (ImGui::Combo("Pressure Solver", &uiSolverMode, solverItems, IM_ARRAYSIZE(solverItems))) {
+        sim.setSolverMode(static_cast<SolverMode>(uiSolverMode));
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Explicit: pressure from the density each step (small dt). IISPH: pressures solved for incompressibility. PBF: density constraints solved on predicted positions. Both hold up at several times the dt");
+    }
+    if (uiSolverMode != static_cast<int>(SolverMode::Explicit)) {
+        uiImplicitRestDensity = static_cast<float>(sim.getImplicitRestDensity());
+        if (ImGui::SliderFloat("Implicit Rest Density", &uiImplicitRestDensity, 0.0f, 3000.0f, "%.1f")) {
+            sim.setImplicitRestDensity(uiImplicitRestDensity);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Density the solver holds the fluid at (0 = capture the current mean density)");
+        }
+        if (ImGui::Button("Capture Rest Density")) {
+            sim.setImplicitRestDensity(0);
+        }
+    }
+    if (uiSolverMode == static_cast<int>(SolverMode::IISPH)) {
+        uiImplicitMaxIterations = sim.getImplicitMaxIterations();
+        if (ImGui::SliderInt("Max Iterations", &uiImplicitMaxIterations, 1, 200, "%d")) {
+            sim.setImplicitMaxIterations(uiImplicitMaxIterations);
+        }
+        uiImplicitTolerance = static_cast<float>(sim.getImplicitTolerance());
+        if (ImGui::SliderFloat("Tolerance", &uiImplicitTolerance, 0.0005f, 0.05f, "%.4f")) {
+            sim.setImplicitTolerance(uiImplicitTolerance);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Average compression (fraction of the rest density) at which iterating stops");
+        }
+    }
+    if (uiSolverMode == static_cast<int>(SolverMode::PBF)) {
+        uiPositionIterations = sim.getPositionIterations();
+        if (ImGui::SliderInt("Iterations", &uiPositionIterations, 1, 20, "%d")) {
+            sim.setPositionIterations(uiPositionIterations);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Constraint iterations per step: more cost time, fewer leave the fluid slightly compressed");
+        }
+    }
+    if (uiSolverMode != static_cast<int>(SolverMode::Explicit)) {
+        ImGui::Text("Last solve: %d iterations, error %.4f", sim.getImplicitIterations(),
+                    static_cast<double>(sim.getImplicitDensityError()));
+    }
+
+    ImGui::Separator();
+    ImGui::Text("Neighbor Search");
+    // sync UI values with simulation
+    uiUseNeighborLists = sim.getUseNeighborLists();
+    float simSkin = static_cast<float>(sim.getNeighborSkin());
+    if (std::abs(uiNeighborSkin - simSkin) > 1e-6f) {
+        uiNeighborSkin = simSkin;
+    }
+    if (ImGui::Checkbox("Verlet Neighbor Lists", &uiUseNeighborLists)) {
+        sim.setUseNeighborLists(uiUseNeighborLists);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Cache neighbors within h + skin and reuse them until a particle moves skin / 2");
+    }
+    if (uiUseNeighborLists) {
+        if (ImGui::SliderFloat("Skin", &uiNeighborSkin, 0.0f, 0.1f, "%.4f")) {
+            sim.setNeighborSkin(static_cast<double>(uiNeighborSkin));
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Extra list radius; larger skins rebuild less often but scan more pairs");
+        }
+        ImGui::Text("List rebuilds: %llu / %llu steps (%.3f per step)",
+                    static_cast<unsigned long long>(sim.getNeighborListRebuilds()),
+                    static_cast<unsigned long long>(sim.getNeighborListSteps()),
+                    sim.getNeighborListRebuildRate());
+    }
+    uiUseSymmetricForces = sim.getUseSymmetricForces();
+    if (ImGui::Checkbox("Symmetric Pair Forces", &uiUseSymmetricForces)) {
+        sim.setUseSymmetricForces(uiUseSymmetricForces);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Evaluate each particle pair once and apply equal-and-opposite pressure forces (off = SIMD gather pass)");
+    }
+
+    ImGui::Separator();
+    ImGui::Text("Memory Layout");
+    // sync UI value with simulation
+    int simReorderInterval = sim.getReorderInterval();
+    if (uiReorderInterval != simReorderInterval) {
+        uiReorderInterval = simReorderInterval;
+    }
+    if (ImGui::SliderInt("Reorder Interval", &uiReorderInterval, 0, 256, "%d")) {
+        sim.setReorderInterval(uiReorderInterval);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Steps between Z-order particle reorders for cache locality (0 = off)");
+    }
+
+    ImGui::Separator();
+    ImGui::Text("Kernels");
+    // sync UI value with simulation (the sim clamps requests to what the CPU supports)
+    uiKernelBackend = static_cast<int>(sim.getKernelBackend());
+    const char* backendItems[] = { "Scalar", "SSE2", "AVX2" };
+    if (ImGui::Combo("SIMD Backend", &uiKernelBackend, backendItems, IM_ARRAYSIZE(backendItems))) {
+        sim.setKernelBackend(static_cast<SimdKernels::Backend>(uiKernelBackend));
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Instruction set for the batched density and gather force passes; best supported: %s",
+                          SimdKernels::backendName(SimdKernels::bestSupportedBackend()));
+    }
+    uiThreadCount = sim.getThreadCount();
+    if (ImGui::SliderInt("Threads", &uiThreadCount, 1, ThreadPool::hardwareThreads())) {
+        sim.setThreadCount(uiThreadCount);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Worker threads for every simulation phase (more than one uses the gather force pass)");
+    }
+    uiDeterministic = sim.getDeterministic();
+    if (ImGui::Checkbox("Deterministic", &uiDeterministic)) {
+        sim.setDeterministic(uiDeterministic);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Byte-identical results for any thread count (always uses the gather force pass)");
+    }
+
     ImGui::Separator();
     ImGui::Checkbox("Color by Velocity", &useVelocityColor);
     if (ImGui::IsItemHovered()) {
@@ -173,6 +381,20 @@ void UIControls::drawGui(FluidSimulation& sim) {
         if (ImGui::Combo("Density Res", &uiDensityResIndex, resItems, IM_ARRAYSIZE(resItems))) {
             // Resolution change handled by caller
         }
+        ImGui::SliderInt("Map Update Interval", &uiDensityUpdateInterval, 1, 10, "%d frames");
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Rebuild the density map only every this many drawn frames");
+        }
+        ImGui::Checkbox("Dirty Tiles Only", &uiDensityDirtyTiles);
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Recompute only the tiles near particles that moved since the map last covered them");
+        }
+        if (uiDensityDirtyTiles) {
+            ImGui::SliderFloat("Dirty Threshold", &uiDensityDirtyThreshold, 0.05f, 2.0f, "%.2f texels");
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("How far a particle has to move before the tiles around it are recomputed");
+            }
+        }
     }
 
     ImGui::Separator();
@@ -1,7 +1,7 @@
 #pragma once
 #include "Vec2.h"
 
-class FluidSimulation; // forward declaration
+class SimulationThread;
 
 // Manages all ImGui UI state and rendering
 class UIControls {
@@ -15,14 +15,38 @@ private:
     float uiViscosityStrength = 0.0f;
     float uiMaxVelocity = 2.01f;
     float uiTimeStep = 0.005f;
+    bool uiAdaptiveTimeStep = false;
+    float uiMinTimeStep = 0.0005f;
+    float uiMaxTimeStep = 0.006f;
+    float uiCflNumber = 0.4f;
+    float uiForceNumber = 0.25f;
     float uiDamping = 0.5f;
     float uiCollisionDamping = 0.0f;
     float uiRestDensity = 5.0f;
+    int uiSolverMode = 0;  // SolverMode
+    float uiImplicitRestDensity = 0.0f;
+    int uiImplicitMaxIterations = 50;
+    float uiImplicitTolerance = 0.005f;
+    int uiPositionIterations = 4;
+    int uiReorderInterval = 32;
+    bool uiUseNeighborLists = false;
+    float uiNeighborSkin = 0.02f;
+    bool uiUseSymmetricForces = true;
+    int uiKernelBackend = 0;  // SimdKernels::Backend
+    int uiThreadCount = 1;
+    bool uiDeterministic = false;
+    bool uiRealTime = true;
+    float uiTimeScale = 1.0f;
+    int uiStepsPerSecond = 60;
+    int uiMaxSubsteps = 8;
     
     // Rendering options
     bool useVelocityColor = true;
     bool showDensityMap = false;
     int uiDensityResIndex = 1; // 0:64, 1:128, 2:256
+    int uiDensityUpdateInterval = 1;
+    bool uiDensityDirtyTiles = false;
+    float uiDensityDirtyThreshold = 0.25f; // Texels
     
     // Interaction settings
     float uiInteractRadius = 0.168f;
@@ -39,12 +63,15 @@ private:
     bool resetRequested = false;
     
 public:
-    void drawGui(FluidSimulation& sim);
+    void drawGui(SimulationThread& sim);
     
     // Getters for UI state
     bool getUseVelocityColor() const { return useVelocityColor; }
     bool getShowDensityMap() const { return showDensityMap; }
     int getDensityResIndex() const { return uiDensityResIndex; }
+    int getDensityUpdateInterval() const { return uiDensityUpdateInterval; }
+    bool getDensityDirtyTiles() const { return uiDensityDirtyTiles; }
+    float getDensityDirtyThreshold() const { return uiDensityDirtyThreshold; }
     
     float getInteractRadius() const { return uiInteractRadius; }
     float getInteractStrength() const { return uiInteractStrength; }
@@ -2,16 +2,19 @@
 
 #include <cmath>
 
-struct Vec2 {
-    float x, y;
-    Vec2(float x = 0, float y = 0) : x(x), y(y) {}
-    Vec2 operator+(const Vec2& other) const { return Vec2(x + other.x, y + other.y); }
-    Vec2 operator*(float scalar) const { return Vec2(x * scalar, y * scalar); }
-    Vec2 operator*(double scalar) const { return Vec2(x * static_cast<float>(scalar), y * static_cast<float>(scalar)); }
-    Vec2 operator*(int scalar) const { return Vec2(x * scalar, y * scalar); }
-    Vec2& operator+=(const Vec2& other) { x += other.x; y += other.y; return *this; }
-    Vec2 operator/(float scalar) const { return Vec2(x / scalar, y / scalar); }
-    Vec2 operator-(Vec2 other) const { return Vec2(x - other.x, y - other.y); }
-    float magnitude() const { return std::sqrt(x * x + y * y); }
-    Vec2 normalized() const { return Vec2(x / magnitude(), y / magnitude()); }
+template <typename T>
+struct Vec2T {
+    T x, y;
+    Vec2T(T x = 0, T y = 0) : x(x), y(y) {}
+    template <typename U>
+    Vec2T(const Vec2T<U>& other) : x(static_cast<T>(other.x)), y(static_cast<T>(other.y)) {}
+    Vec2T operator+(const Vec2T& other) const { return Vec2T(x + other.x, y + other.y); }
+    Vec2T operator*(T scalar) const { return Vec2T(x * scalar, y * scalar); }
+    Vec2T& operator+=(const Vec2T& other) { x += other.x; y += other.y; return *this; }
+    Vec2T operator/(T scalar) const { return Vec2T(x / scalar, y / scalar); }
+    Vec2T operator-(Vec2T other) const { return Vec2T(x - other.x, y - other.y); }
+    T magnitude() const { return std::sqrt(x * x + y * y); }
+    Vec2T normalized() const { return Vec2T(x / magnitude(), y / magnitude()); }
 };
+
+using Vec2 = Vec2T<float>;
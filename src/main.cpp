@@ -1,6 +1,7 @@
 #include <iostream>
 #include <vector>
 #include "FluidSimulation.h"
+#include "SimulationThread.h"
 #include "Renderer.h"
 
 using namespace std;
@@ -9,6 +10,7 @@ int main() {
     // Create simulation
     FluidSimulation sim(300); // 150 particles for example
     //FluidSimulation sim(15,15,0.06,Vec2(-0.5,-0.5)); // grid particles for example
+    sim.setThreadCount(ThreadPool::hardwareThreads());
     cout << "Test log" << endl;
 
     // Initialize renderer
@@ -18,11 +20,21 @@ int main() {
         return -1;
     }
 
+    // The simulation steps on its own thread from here on; this thread only sends it
+    // commands and draws the newest snapshot
+    SimulationThread simThread(sim);
+    simThread.start();
+
+    // Interpolated particle positions, reused every frame
+    std::vector<SimReal> blendX, blendY;
+
     // Main loop
     while (!renderer.shouldClose()) {
+        const SimSnapshot& snapshot = simThread.acquireSnapshot();
+
         // Check if reset was requested
         if (renderer.isResetRequested()) {
-            sim.resetParticles(
+            simThread.resetParticles(
                 renderer.getParticleCount(),
                 renderer.getSpreadX(),
                 renderer.getSpreadY(),
@@ -36,19 +48,18 @@ int main() {
         Vec2 interactPoint;
         float interactStrength = 0.0f;
         float interactRadius = 0.0f;
-        if (renderer.getInteraction(interactPoint, interactStrength, interactRadius)) {
-            sim.applyInteraction(interactPoint, interactStrength, interactRadius);
-        }
-        
-        sim.update();
+        const bool interacting = renderer.getInteraction(interactPoint, interactStrength, interactRadius);
+        simThread.setInteraction(interacting, interactPoint, interactStrength, interactRadius);
 
         renderer.beginFrame();
-        renderer.drawDensityMap(sim);
-        renderer.drawParticles(sim.getPositions(), sim.getMaxVelocity());
-        renderer.drawGui(sim);
+        renderer.drawDensityMap(snapshot);
+        const SimReal alpha = static_cast<SimReal>(simThread.interpolationAlpha(snapshot));
+        renderer.drawParticles(snapshot.interpolatedView(alpha, blendX, blendY), snapshot.settings.maxVelocity);
+        renderer.drawGui(simThread);
         renderer.endFrame();
     }
 
+    simThread.stop();
     renderer.cleanup();
     return 0;
 }
@@ -0,0 +1,29 @@
+#pragma once
+#include "FluidSimulation.h"
+#include <cstdlib>
+
+// The scene every tool in tools/ starts from: the UI defaults in UIControls, spawned
+// from a fixed seed so runs (and tools) can be compared particle for particle.
+
+const unsigned kBenchSeed = 12345;
+
+// Settings a tool may change from the UI defaults
+struct BenchSceneOptions {
+    double viscosity = 0.0;
+};
+
+template <typename Real>
+void setupScene(BasicFluidSimulation<Real>& sim, int count, const BenchSceneOptions& options = BenchSceneOptions()) {
+    sim.setGravity(Vec2(0.0f, -10.0f));
+    sim.setSmoothingRadius(Real(0.16433));
+    sim.setPressureMultiplier(Real(4.12456));
+    sim.setNearPressureMultiplier(Real(0.93206));
+    sim.setViscosityStrength(Real(options.viscosity));
+    sim.setMaxVelocity(Real(2.01));
+    sim.setTimeStep(Real(0.005));
+    sim.setDamping(Real(0.5));
+    sim.setCollisionDamping(Real(0.0));
+    sim.setRestDensity(Real(5.0));
+    srand(kBenchSeed);
+    sim.resetParticles(count, 1.6f, 0.8f, 0.0f, 0.0f);
+}
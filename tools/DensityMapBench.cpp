@@ -0,0 +1,106 @@
+// Times DensityMapBuilder on a snapshot of the default scene at each density map
+// resolution the UI offers: the splat pass alone on one thread, and the whole build
+// (splat, min/max, coloring) on the builder's pool. Then steps the simulation once per
+// frame and compares a full build against the dirty-tile update, reporting the share of
+// tiles the update redid (mean and worst frame) and how far its colors ended up from the
+// full build's.
+//
+// Usage: density_map_bench [particles=2000] [warmupSteps=200] [frames=50] [threads=half]
+//                          [threshold=0.25 texels]
+#include "FluidSimulation.h"
+#include "BenchScene.h"
+#include "SimSnapshot.h"
+#include "DensityMapBuilder.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+template <typename Fn>
+double timedMs(Fn&& fn) {
+    auto t0 = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+template <typename Fn>
+double bestOfMs(int reps, Fn&& fn) {
+    double best = 1e300;
+    for (int r = 0; r < reps; ++r) {
+        auto t0 = std::chrono::steady_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int count = argc > 1 ? std::max(1, atoi(argv[1])) : 2000;
+    const int warmup = argc > 2 ? std::max(0, atoi(argv[2])) : 200;
+    const int frames = argc > 3 ? std::max(1, atoi(argv[3])) : 50;
+    const int threads = argc > 4 ? std::max(1, atoi(argv[4])) : std::max(1, ThreadPool::hardwareThreads() / 2);
+    const double threshold = argc > 5 ? std::max(0.0, atof(argv[5])) : 0.25;
+
+    FluidSimulation sim(0);
+    setupScene(sim, count);
+    for (int s = 0; s < warmup; ++s) sim.update();
+    SimSnapshot snapshot;
+    sim.writeSnapshot(snapshot);
+
+    std::printf("density_map_bench: %zu particles, best of %d frames, %d builder threads\n",
+                snapshot.size(), frames, threads);
+    std::printf("  %-10s %12s %12s %12s\n", "resolution", "splat ms", "build ms", "other ms");
+    const int resolutions[] = { 64, 128, 256 };
+    for (int res : resolutions) {
+        DensityMapBuilder builder(threads, res, res);
+        // Reference: the splat alone over every row, serially
+        std::vector<SimReal> gx(res), gy(res), rho(static_cast<size_t>(res) * res);
+        for (int i = 0; i < res; ++i) gx[i] = gy[i] = static_cast<SimReal>(-1.0f + (2.0f * (i + 0.5f) / res));
+        const double splatMs = bestOfMs(frames, [&] {
+            snapshot.densityGrid(gx.data(), res, gy.data(), res, 0, res, rho.data());
+        });
+        const double buildMs = bestOfMs(frames, [&] { builder.build(snapshot); });
+        std::printf("  %4dx%-5d %12.3f %12.3f %12.3f\n", res, res, splatMs, buildMs,
+                    std::max(0.0, buildMs - splatMs / threads));
+    }
+
+    // One simulation step per frame; the same snapshots feed both builders
+    std::printf("  stepping %d frames, dirty threshold %.2f texels\n", frames, threshold);
+    std::printf("  %-10s %12s %12s %12s %12s %12s\n", "resolution", "build ms", "update ms", "dirty tiles", "peak dirty",
+                "max color diff");
+    for (int res : resolutions) {
+        FluidSimulation stepped(0);
+        setupScene(stepped, count);
+        for (int s = 0; s < warmup; ++s) stepped.update();
+        stepped.writeSnapshot(snapshot);
+        DensityMapBuilder full(threads, res, res);
+        DensityMapBuilder incremental(threads, res, res);
+        incremental.update(snapshot, threshold);
+
+        double buildMs = 0.0;
+        double updateMs = 0.0;
+        double dirtyShare = 0.0;
+        double peakDirty = 0.0;
+        for (int f = 0; f < frames; ++f) {
+            stepped.update();
+            stepped.writeSnapshot(snapshot);
+            buildMs += timedMs([&] { full.build(snapshot); });
+            updateMs += timedMs([&] { incremental.update(snapshot, threshold); });
+            const double share = static_cast<double>(incremental.getDirtyTileCount()) / incremental.getTileCount();
+            dirtyShare += share;
+            peakDirty = std::max(peakDirty, share);
+        }
+        int maxDiff = 0;
+        for (size_t k = 0; k < static_cast<size_t>(res) * res * 3; ++k) {
+            maxDiff = std::max(maxDiff, std::abs(full.getPixels()[k] - incremental.getPixels()[k]));
+        }
+        std::printf("  %4dx%-5d %12.3f %12.3f %11.1f%% %11.1f%% %12d\n", res, res, buildMs / frames, updateMs / frames,
+                    100.0 * dirtyShare / frames, 100.0 * peakDirty, maxDiff);
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+// Probes the density field of the default scene on a regular grid of points and times
+// the brute-force Poly6 sum over every particle against densityAtFast (grid walk, one
+// point at a time) and densityAtBatch (cell-sorted, on the thread pool). Fails if either
+// grid query deviates from the brute-force sum by more than the tolerance.
+//
+// Usage: density_query_bench [particles=2000] [warmupSteps=200] [resolution=256]
+#include "FluidSimulation.h"
+#include "BenchScene.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+const double kTolerance = 1e-9;  // Relative to the largest density; only summation order differs
+
+template <typename Fn>
+double timedMs(Fn&& fn) {
+    auto t0 = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+double maxRelError(const std::vector<double>& ref, const std::vector<double>& got) {
+    double maxRef = 0.0;
+    double maxErr = 0.0;
+    for (size_t q = 0; q < ref.size(); ++q) {
+        maxRef = std::max(maxRef, ref[q]);
+        maxErr = std::max(maxErr, std::abs(ref[q] - got[q]));
+    }
+    return maxRef > 0.0 ? maxErr / maxRef : maxErr;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int count = argc > 1 ? std::max(1, atoi(argv[1])) : 2000;
+    const int warmup = argc > 2 ? std::max(0, atoi(argv[2])) : 200;
+    const int resolution = argc > 3 ? std::max(1, atoi(argv[3])) : 256;
+
+    FluidSimulation sim(0);
+    setupScene(sim, count);
+    for (int s = 0; s < warmup; ++s) sim.update();
+
+    // Texel centers of a resolution x resolution density map over [-1, 1]^2
+    const size_t n = static_cast<size_t>(resolution) * resolution;
+    std::vector<float> xs(n), ys(n);
+    for (int j = 0; j < resolution; ++j) {
+        for (int i = 0; i < resolution; ++i) {
+            xs[static_cast<size_t>(j) * resolution + i] = -1.0f + 2.0f * (i + 0.5f) / resolution;
+            ys[static_cast<size_t>(j) * resolution + i] = -1.0f + 2.0f * (j + 0.5f) / resolution;
+        }
+    }
+
+    const ParticleView view = sim.getParticleView();
+    const std::vector<SimReal> px(view.x.begin(), view.x.end());
+    const std::vector<SimReal> py(view.y.begin(), view.y.end());
+    const std::vector<SimReal> mass(px.size(), SimReal(1));  // resetParticles gives every particle unit mass
+    const SPHKernels::KernelSet<SimReal> kernels(sim.getSmoothingRadius());
+
+    std::vector<double> brute(n), single(n), batch(n);
+    const double bruteMs = timedMs([&] {
+        for (size_t q = 0; q < n; ++q) {
+            const SimReal d = SPHKernels::sampleDensity2D(kernels, px.data(), py.data(), mass.data(), px.size(),
+                                                          static_cast<SimReal>(xs[q]), static_cast<SimReal>(ys[q]));
+            brute[q] = std::max(static_cast<double>(d), 1e-6);
+        }
+    });
+    const double singleMs = timedMs([&] {
+        for (size_t q = 0; q < n; ++q) single[q] = sim.densityAtFast(xs[q], ys[q]);
+    });
+    const double batchMs = timedMs([&] { sim.densityAtBatch(xs.data(), ys.data(), n, batch.data()); });
+
+    const double singleErr = maxRelError(brute, single);
+    const double batchErr = maxRelError(brute, batch);
+    const bool ok = singleErr <= kTolerance && batchErr <= kTolerance;
+    std::printf("density_query_bench: %zu particles, %zu points, %d threads\n", px.size(), n, sim.getThreadCount());
+    std::printf("  %-14s %10s %9s %12s\n", "query", "ms", "speedup", "maxErr/max");
+    std::printf("  %-14s %10.2f %8.2fx\n", "brute force", bruteMs, 1.0);
+    std::printf("  %-14s %10.2f %8.2fx %12.3e %s\n", "densityAtFast", singleMs, bruteMs / singleMs, singleErr,
+                singleErr <= kTolerance ? "ok" : "FAIL");
+    std::printf("  %-14s %10.2f %8.2fx %12.3e %s\n", "densityAtBatch", batchMs, bruteMs / batchMs, batchErr,
+                batchErr <= kTolerance ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+// Runs the default scene in deterministic mode at several thread counts and checks
+// that the particle state hash is identical at every checkpoint, for both neighbor
+// search modes.
+//
+// Usage: determinism_check [particles=4000] [steps=200] [threads=1,8,64] [checkEvery=50]
+#include "FluidSimulation.h"
+#include "BenchScene.h"
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<int> parseThreadList(const char* text) {
+    std::vector<int> out;
+    std::string token;
+    for (const char* c = text;; ++c) {
+        if (*c == ',' || *c == '\0') {
+            if (!token.empty()) out.push_back(std::max(1, atoi(token.c_str())));
+            token.clear();
+            if (*c == '\0') break;
+        } else {
+            token += *c;
+        }
+    }
+    return out;
+}
+
+// Hash after every checkpoint of one run
+std::vector<uint64_t> runHashes(int count, int steps, int checkEvery, int threads, bool neighborLists,
+                                double& kineticEnergy) {
+    FluidSimulation sim(0);
+    setupScene(sim, count);
+    sim.setDeterministic(true);
+    sim.setUseNeighborLists(neighborLists);
+    sim.setThreadCount(threads);
+    std::vector<uint64_t> hashes;
+    for (int step = 1; step <= steps; ++step) {
+        sim.update();
+        if (step % checkEvery == 0 || step == steps) hashes.push_back(sim.getStateHash());
+    }
+    kineticEnergy = sim.getKineticEnergy();
+    return hashes;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int count = argc > 1 ? std::max(1, atoi(argv[1])) : 4000;
+    const int steps = argc > 2 ? std::max(1, atoi(argv[2])) : 200;
+    const std::vector<int> threadCounts = parseThreadList(argc > 3 ? argv[3] : "1,8,64");
+    const int checkEvery = argc > 4 ? std::max(1, atoi(argv[4])) : 50;
+    if (threadCounts.empty()) {
+        std::fprintf(stderr, "determinism_check: no thread counts given\n");
+        return 2;
+    }
+
+    std::printf("determinism_check: %d particles, %d steps, %s kernels\n", count, steps,
+                SimdKernels::backendName(SimdKernels::bestSupportedBackend()));
+    bool ok = true;
+    for (int mode = 0; mode < 2; ++mode) {
+        const bool lists = mode == 1;
+        std::printf("%s:\n", lists ? "verlet lists" : "grid");
+        std::vector<uint64_t> reference;
+        for (int threads : threadCounts) {
+            double energy = 0.0;
+            const std::vector<uint64_t> hashes = runHashes(count, steps, checkEvery, threads, lists, energy);
+            if (reference.empty()) reference = hashes;
+            int firstMismatch = -1;
+            for (size_t k = 0; k < hashes.size(); ++k) {
+                if (hashes[k] != reference[k]) {
+                    firstMismatch = static_cast<int>(k);
+                    break;
+                }
+            }
+            std::printf("  %3d threads  hash %016" PRIx64 "  kinetic %.17g  %s", threads, hashes.back(), energy,
+                        firstMismatch < 0 ? "match" : "MISMATCH");
+            if (firstMismatch >= 0) {
+                std::printf(" (first at step %d)", std::min(steps, (firstMismatch + 1) * checkEvery));
+                ok = false;
+            }
+            std::printf("\n");
+        }
+    }
+    std::printf("%s\n", ok ? "deterministic" : "NOT deterministic");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+// Times the batched pressure-force kernel on every available backend against the
+// scalar calculateGradient pass, and checks each backend's gradients against it.
+// A nonzero viscosity adds calculateViscosity to the reference and the kernel.
+// The float AVX2 kernel (8 lanes) must reach 3x the scalar pass; the double kernel
+// has 4 lanes and reports its speedup without a target.
+//
+// Usage: force_kernel_bench [particles=4000] [warmupSteps=200] [reps=20] [viscosity=0]
+#include "FluidSimulation.h"
+#include "BenchScene.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+template <typename Fn>
+double bestOfMs(int reps, Fn&& fn) {
+    double best = 1e300;
+    for (int r = 0; r < reps; ++r) {
+        auto t0 = std::chrono::steady_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+    }
+    return best;
+}
+
+const double kAvx2TargetSpeedup = 3.0;
+
+// Returns false when a backend differs from the scalar pass by more than the tolerance,
+// or when the AVX2 kernel misses its speedup target (if it has one)
+template <typename Real>
+bool run(const char* label, int count, int warmup, int reps, double viscosity, double tolerance,
+         double avx2Target) {
+    BasicFluidSimulation<Real> sim(0);
+    setupScene(sim, count, BenchSceneOptions{ viscosity });
+    for (int s = 0; s < warmup; ++s) sim.update();
+
+    const size_t n = sim.getParticleCount();
+    std::vector<Real> refX(n), refY(n);
+    const double scalarMs = bestOfMs(reps, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            const auto g = sim.calculateGradient(i) + sim.calculateViscosity(i);
+            refX[i] = g.x;
+            refY[i] = g.y;
+        }
+    });
+    double refMax = 0.0;
+    for (size_t i = 0; i < n; ++i) refMax = std::max(refMax, std::hypot(double(refX[i]), double(refY[i])));
+
+    std::printf("%s: %zu particles, scalar calculateGradient pass %.3f ms\n", label, n, scalarMs);
+    std::printf("  %-8s %10s %9s %12s\n", "backend", "ms", "speedup", "maxErr/max|g|");
+    bool ok = true;
+    std::vector<Real> gx, gy;
+    const SimdKernels::Backend backends[] = { SimdKernels::Backend::Scalar, SimdKernels::Backend::SSE,
+                                              SimdKernels::Backend::AVX2 };
+    for (SimdKernels::Backend b : backends) {
+        if (!SimdKernels::isSupported(b)) {
+            std::printf("  %-8s %10s\n", SimdKernels::backendName(b), "n/a");
+            continue;
+        }
+        sim.setKernelBackend(b);
+        const double ms = bestOfMs(reps, [&] { sim.computePressureGradients(gx, gy); });
+        double maxErr = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            maxErr = std::max(maxErr, std::hypot(double(gx[i] - refX[i]), double(gy[i] - refY[i])));
+        }
+        const double relErr = refMax > 0.0 ? maxErr / refMax : maxErr;
+        const double speedup = ms > 0.0 ? scalarMs / ms : 0.0;
+        const bool pass = relErr <= tolerance;
+        ok = ok && pass;
+        std::printf("  %-8s %10.3f %8.2fx %12.3e %s\n", SimdKernels::backendName(b), ms,
+                    speedup, relErr, pass ? "ok" : "FAIL");
+        if (b == SimdKernels::Backend::AVX2 && avx2Target > 0.0 && speedup < avx2Target) {
+            std::printf("  FAIL: AVX2 speedup %.2fx is below the %.1fx target\n", speedup, avx2Target);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int count = argc > 1 ? std::max(1, atoi(argv[1])) : 4000;
+    const int warmup = argc > 2 ? std::max(0, atoi(argv[2])) : 200;
+    const int reps = argc > 3 ? std::max(1, atoi(argv[3])) : 20;
+    const double viscosity = argc > 4 ? std::max(0.0, atof(argv[4])) : 0.0;
+
+    std::printf("force_kernel_bench: best of %d reps after %d warmup steps, viscosity %g (target: float AVX2 >= %gx scalar)\n",
+                reps, warmup, viscosity, kAvx2TargetSpeedup);
+    bool ok = run<float>("float", count, warmup, reps, viscosity, 1e-4, kAvx2TargetSpeedup);
+    ok = run<double>("double", count, warmup, reps, viscosity, 1e-9, 0.0) && ok;
+    return ok ? 0 : 1;
+}
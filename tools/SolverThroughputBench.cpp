@@ -0,0 +1,111 @@
+// Runs the default scene with each pressure solver over a range of fixed time steps and
+// reports simulated seconds per wall second. A run counts as stable when its state stays
+// finite and the fluid has settled by the end: the rms particle speed over the last
+// simulated second is below kSettledSpeed. Each solver's fastest stable run is then
+// compared against the fastest stable explicit run.
+//
+// Usage: solver_throughput_bench [particles=2000] [seconds=4] [threads=all]
+#include "FluidSimulation.h"
+#include "BenchScene.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+namespace {
+
+const double kSettledSpeed = 0.15;   // m/s, rms over the last simulated second
+const double kTimeSteps[] = { 0.002, 0.004, 0.006, 0.008, 0.010, 0.012, 0.014, 0.016,
+                              0.020, 0.025, 0.030, 0.040 };
+
+struct RunResult {
+    double rate = 0.0;        // Simulated seconds per wall second
+    double rmsSpeed = 0.0;    // Over the last simulated second
+    double peakDensity = 0.0; // Largest density over the mean density, same window
+    double iterations = 0.0;  // Mean solver iterations per step (0 for explicit)
+    bool stable = false;
+};
+
+RunResult runSolver(SolverMode mode, double dt, int count, double seconds, int threads) {
+    FluidSimulation sim(0);
+    setupScene(sim, count);
+    sim.setThreadCount(threads);
+    sim.setSolverMode(mode);
+    sim.setTimeStep(dt);
+
+    const int steps = std::max(1, static_cast<int>(seconds / dt + 0.5));
+    const int windowStart = std::max(0, steps - static_cast<int>(1.0 / dt + 0.5));
+    double energy = 0.0, peak = 0.0, iterations = 0.0;
+    bool finite = true;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; ++s) {
+        sim.update();
+        iterations += sim.getImplicitIterations();
+        if (s < windowStart) continue;
+        const double kinetic = sim.getKineticEnergy();
+        finite = finite && std::isfinite(kinetic);
+        energy += kinetic;
+        const auto densities = sim.getDensities();
+        double largest = 0.0, sum = 0.0;
+        for (size_t i = 0; i < densities.size(); ++i) {
+            largest = std::max(largest, double(densities[i]));
+            sum += densities[i];
+        }
+        if (sum > 0.0) peak = std::max(peak, largest * densities.size() / sum);
+    }
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    // Every particle has unit mass, so KE = sum v^2 / 2
+    RunResult r;
+    r.rate = steps * dt / wall;
+    r.rmsSpeed = std::sqrt(2.0 * energy / (steps - windowStart) / sim.getParticleCount());
+    r.peakDensity = peak;
+    r.iterations = iterations / steps;
+    r.stable = finite && r.rmsSpeed < kSettledSpeed;
+    return r;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int count = argc > 1 ? std::max(1, atoi(argv[1])) : 2000;
+    const double seconds = argc > 2 ? std::max(1.5, atof(argv[2])) : 4.0;
+    const int threads = argc > 3 ? std::max(1, atoi(argv[3])) : ThreadPool::hardwareThreads();
+
+    std::printf("solver_throughput_bench: %d particles, %g simulated s per run, %d threads, "
+                "stable = rms speed < %g m/s over the last second\n", count, seconds, threads, kSettledSpeed);
+    std::printf("  %-8s %7s %13s %7s %9s %10s\n", "solver", "dt", "sim-s/wall-s", "iters", "rms m/s", "peak/mean");
+
+    const SolverMode modes[] = { SolverMode::Explicit, SolverMode::IISPH, SolverMode::PBF };
+    double bestRate[3] = { 0.0, 0.0, 0.0 };
+    double bestDt[3] = { 0.0, 0.0, 0.0 };
+    for (int m = 0; m < 3; ++m) {
+        for (double dt : kTimeSteps) {
+            const RunResult r = runSolver(modes[m], dt, count, seconds, threads);
+            std::printf("  %-8s %7.3f %13.2f %7.1f %9.3f %10.2f %s\n", solverModeName(modes[m]), dt, r.rate,
+                        r.iterations, r.rmsSpeed, r.peakDensity, r.stable ? "stable" : "unsettled");
+            if (r.stable && r.rate > bestRate[m]) {
+                bestRate[m] = r.rate;
+                bestDt[m] = dt;
+            }
+        }
+    }
+
+    std::printf("fastest stable run of each solver:\n");
+    for (int m = 0; m < 3; ++m) {
+        if (bestRate[m] == 0.0) {
+            std::printf("  %-8s none\n", solverModeName(modes[m]));
+            continue;
+        }
+        std::printf("  %-8s dt %.3f %8.2f sim-s/wall-s", solverModeName(modes[m]), bestDt[m], bestRate[m]);
+        if (m == 0) {
+            std::printf("  (reference)\n");
+        } else if (bestRate[0] > 0.0) {
+            std::printf("  %.2fx explicit\n", bestRate[m] / bestRate[0]);
+        } else {
+            std::printf("\n");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+// Measures update() throughput of the default scene from one thread up to every
+// hardware thread (doubling, plus the full count) and reports the parallel scaling.
+//
+// Usage: thread_scaling_bench [particles=20000] [steps=100] [maxThreads=all]
+#include "FluidSimulation.h"
+#include "BenchScene.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+const int kWarmupSteps = 20;
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int count = argc > 1 ? std::max(1, atoi(argv[1])) : 20000;
+    const int steps = argc > 2 ? std::max(1, atoi(argv[2])) : 100;
+    const int maxThreads = argc > 3 ? std::max(1, atoi(argv[3])) : ThreadPool::hardwareThreads();
+
+    std::vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    std::printf("thread_scaling_bench: %d particles, %d steps after %d warmup, %s kernels\n",
+                count, steps, kWarmupSteps,
+                SimdKernels::backendName(SimdKernels::bestSupportedBackend()));
+    std::printf("%8s %12s %10s %9s %11s\n", "threads", "steps/s", "ms/step", "speedup", "efficiency");
+
+    double baseline = 0.0;
+    for (int threads : threadCounts) {
+        FluidSimulation sim(0);
+        setupScene(sim, count);
+        // The symmetric pair pass is single-threaded only; use the gather pass everywhere
+        // so every row does the same work
+        sim.setUseSymmetricForces(false);
+        sim.setThreadCount(threads);
+        for (int s = 0; s < kWarmupSteps; ++s) sim.update();
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (int s = 0; s < steps; ++s) sim.update();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        const double rate = steps / seconds;
+        if (baseline == 0.0) baseline = rate;
+        const double speedup = rate / baseline;
+        std::printf("%8d %12.1f %10.3f %8.2fx %10.0f%%\n", threads, rate, 1000.0 / rate, speedup,
+                    100.0 * speedup / threads);
+    }
+    return 0;
+}